@@ -0,0 +1,122 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+
+// One group element: the same (i, j) of BATCH_LANES matrices
+typedef int bvec __attribute__((vector_size(BATCH_LANES * sizeof(int))));
+
+// The operands of one batched operation
+typedef struct {
+    const MatrixBatch *A;
+    const MatrixBatch *B;
+    MatrixBatch *C;
+    MatrixBatch *D;
+} BatchJob;
+
+// Allocates the interleaved buffer on a cache line and clears it
+MatrixBatch *batchAlloc(int count, int rows, int cols) {
+    MatrixBatch *t;
+    void *data;
+    size_t bytes;
+
+    if (count <= 0 || rows <= 0 || cols <= 0) {
+        return NULL;
+    }
+    t = malloc(sizeof(MatrixBatch));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->count = count;
+    t->rows = rows;
+    t->cols = cols;
+    t->groups = (count + BATCH_LANES - 1) / BATCH_LANES;
+    bytes = (size_t)t->groups * rows * cols * BATCH_LANES * sizeof(int);
+    if (posix_memalign(&data, MATRIX_ALIGN, bytes) != 0) {
+        free(t);
+        return NULL;
+    }
+    memset(data, 0, bytes);
+    t->data = data;
+    return t;
+}
+
+// Frees the buffer and the batch; NULL is ignored
+void batchFree(MatrixBatch *t) {
+    if (t == NULL) {
+        return;
+    }
+    free(t->data);
+    free(t);
+}
+
+// Scatters a matrix into its lane of the batch
+void batchSet(MatrixBatch *t, int b, const Matrix *m) {
+    for (int i = 0; i < t->rows; i++) {
+        for (int j = 0; j < t->cols; j++) {
+            BATCH_AT(t, b, i, j) = MAT(m, i, j);
+        }
+    }
+}
+
+// Gathers one lane of the batch into a matrix
+void batchGet(const MatrixBatch *t, int b, Matrix *m) {
+    for (int i = 0; i < t->rows; i++) {
+        for (int j = 0; j < t->cols; j++) {
+            MAT(m, i, j) = BATCH_AT(t, b, i, j);
+        }
+    }
+}
+
+// Multiplies the assigned groups, BATCH_LANES matrices per vector operation
+static void multiplyGroups(void *arg, int start, int end) {
+    BatchJob *job = arg;
+    int m = job->A->rows, k = job->A->cols, n = job->B->cols;
+
+    for (int g = start; g < end; g++) {
+        const bvec *a = (const bvec *)job->A->data + (size_t)g * m * k;
+        const bvec *b = (const bvec *)job->B->data + (size_t)g * k * n;
+        bvec *c = (bvec *)job->C->data + (size_t)g * m * n;
+
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                bvec sum = { 0 };
+
+                for (int p = 0; p < k; p++) {
+                    sum += a[i * k + p] * b[p * n + j];
+                }
+                c[i * n + j] = sum;
+            }
+        }
+    }
+}
+
+// Multiplies every matrix pair of the batches, one task per range of groups
+void batchMultiply(ThreadPool *pool, const MatrixBatch *A, const MatrixBatch *B, MatrixBatch *C) {
+    BatchJob job = { A, B, C, NULL };
+
+    poolParallelFor(pool, multiplyGroups, &job, A->groups);
+}
+
+// Adds and subtracts the assigned groups; a group is one flat run of vectors
+static void sumDiffGroups(void *arg, int start, int end) {
+    BatchJob *job = arg;
+    size_t per_group = (size_t)job->A->rows * job->A->cols;
+    const bvec *a = (const bvec *)job->A->data;
+    const bvec *b = (const bvec *)job->B->data;
+    bvec *sum = (bvec *)job->C->data;
+    bvec *diff = (bvec *)job->D->data;
+
+    for (size_t e = start * per_group; e < end * per_group; e++) {
+        sum[e] = a[e] + b[e];
+        diff[e] = a[e] - b[e];
+    }
+}
+
+// Adds and subtracts every matrix pair of the batches, one task per range of groups
+void batchSumDiff(ThreadPool *pool, const MatrixBatch *A, const MatrixBatch *B,
+                  MatrixBatch *sum, MatrixBatch *diff) {
+    BatchJob job = { A, B, sum, diff };
+
+    poolParallelFor(pool, sumDiffGroups, &job, A->groups);
+}
@@ -0,0 +1,56 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "dense.h"
+#include "threadpool.h"
+
+/**
+ * Batches of small matrices.
+ *
+ * A 20 x 20 product is far too small to split across threads or to fill
+ * vector registers along a row, so batches vectorize across matrices
+ * instead: matrices are stored in groups of BATCH_LANES, interleaved so
+ * that element (i, j) of the BATCH_LANES matrices of a group is one
+ * contiguous vector. A kernel then does the scalar algorithm once per
+ * group with every operation BATCH_LANES wide, and the workers split the
+ * groups between them, so one pool call covers the whole batch.
+ *
+ * Element (i, j) of matrix b is
+ *     data[((b / BATCH_LANES * rows + i) * cols + j) * BATCH_LANES + b % BATCH_LANES].
+ * The unused lanes of a partial last group are zero.
+ */
+
+/* Matrices per group: 8 ints = 32 bytes, one vector. */
+#define BATCH_LANES 8
+
+typedef struct {
+    int count;          // matrices in the batch
+    int rows;
+    int cols;
+    int groups;         // count rounded up to whole groups of BATCH_LANES
+    int *data;
+} MatrixBatch;
+
+/* Element (i, j) of matrix b of batch t. */
+#define BATCH_AT(t, b, i, j) \
+    ((t)->data[(((size_t)((b) / BATCH_LANES) * (t)->rows + (i)) * (t)->cols + (j)) * BATCH_LANES \
+               + (b) % BATCH_LANES])
+
+/* Allocates a zeroed batch of count rows x cols matrices, or returns NULL. */
+MatrixBatch *batchAlloc(int count, int rows, int cols);
+
+void batchFree(MatrixBatch *t);
+
+/* Copies m (of the batch's shape) in as matrix b, or matrix b out to m. */
+void batchSet(MatrixBatch *t, int b, const Matrix *m);
+void batchGet(const MatrixBatch *t, int b, Matrix *m);
+
+/* C[b] = A[b] * B[b] for every b; A is m x k, B k x n and C m x n, all
+ * with the same count. */
+void batchMultiply(ThreadPool *pool, const MatrixBatch *A, const MatrixBatch *B, MatrixBatch *C);
+
+/* sum[b] = A[b] + B[b] and diff[b] = A[b] - B[b] for every b. */
+void batchSumDiff(ThreadPool *pool, const MatrixBatch *A, const MatrixBatch *B,
+                  MatrixBatch *sum, MatrixBatch *diff);
+
+#endif				// BATCH_H
@@ -0,0 +1,91 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "dense.h"
+
+// Rounds cols up to whole cache lines and breaks 4 KiB row strides
+int matrixLeadingDimSized(int cols, int elem_size) {
+    int line = MATRIX_ALIGN / elem_size;
+    int ld = (cols + line - 1) / line * line;
+
+    if (ld == 0) {
+        ld = line;
+    }
+    if (((size_t)ld * elem_size) % 4096 == 0) {
+        ld += line;
+    }
+    return ld;
+}
+
+// Leading dimension of an int matrix
+int matrixLeadingDim(int cols) {
+    return matrixLeadingDimSized(cols, sizeof(int));
+}
+
+// Allocates an aligned, padded buffer of rows x cols elements of elem_size bytes
+void *matrixAllocBuffer(int rows, int cols, int elem_size, int *ld) {
+    void *data;
+
+    if (rows <= 0 || cols <= 0) {
+        return NULL;
+    }
+    *ld = matrixLeadingDimSized(cols, elem_size);
+    if (posix_memalign(&data, MATRIX_ALIGN, (size_t)rows * *ld * elem_size) != 0) {
+        return NULL;
+    }
+    return data;
+}
+
+// Allocates a matrix header and its aligned, padded element buffer
+Matrix *matrixAlloc(int rows, int cols) {
+    Matrix *m;
+    void *data;
+
+    if (rows <= 0 || cols <= 0) {
+        return NULL;
+    }
+
+    m = malloc(sizeof(Matrix));
+    if (m == NULL) {
+        return NULL;
+    }
+    m->rows = rows;
+    m->cols = cols;
+    m->ld = matrixLeadingDim(cols);
+    m->map = NULL;
+    m->map_size = 0;
+
+    if (posix_memalign(&data, MATRIX_ALIGN, (size_t)rows * m->ld * sizeof(int)) != 0) {
+        free(m);
+        return NULL;
+    }
+    m->data = data;
+    return m;
+}
+
+// Frees a matrix and its element buffer or file mapping
+void matrixFree(Matrix *m) {
+    if (m == NULL) {
+        return;
+    }
+    if (m->map != NULL) {
+        munmap(m->map, m->map_size);
+    } else {
+        free(m->data);
+    }
+    free(m);
+}
+
+// Compares two matrices row by row, ignoring the padding
+int matrixEqual(const Matrix *a, const Matrix *b) {
+    if (a->rows != b->rows || a->cols != b->cols) {
+        return 0;
+    }
+    for (int i = 0; i < a->rows; i++) {
+        if (memcmp(&MAT(a, i, 0), &MAT(b, i, 0), a->cols * sizeof(int)) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
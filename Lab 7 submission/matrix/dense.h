@@ -0,0 +1,51 @@
+#ifndef DENSE_H
+#define DENSE_H
+
+/**
+ * Runtime-sized dense matrices.
+ *
+ * Elements are stored row-major in one 64-byte-aligned buffer. Each row
+ * starts on a cache line: the leading dimension ld is cols rounded up to a
+ * whole number of cache lines, and is padded by one more line whenever a
+ * row would span a multiple of 4 KiB. Otherwise walking down a column of a
+ * large matrix maps every row to the same cache set.
+ */
+
+#include <stddef.h>
+
+#define MATRIX_ALIGN 64
+#define MATRIX_LINE_INTS (MATRIX_ALIGN / (int)sizeof(int))
+
+typedef struct {
+    int rows;
+    int cols;
+    int ld;         // elements between the starts of consecutive rows
+    int *data;
+    void *map;      // file mapping that holds data (see matrixio.h), or NULL
+    size_t map_size;
+} Matrix;
+
+/* Element (i, j) of matrix m. */
+#define MAT(m, i, j) ((m)->data[(size_t)(i) * (m)->ld + (j)])
+
+/* Allocates an uninitialized rows x cols matrix, or returns NULL. */
+Matrix *matrixAlloc(int rows, int cols);
+
+/* Frees a matrix, or unmaps it if it was mapped from a file. */
+void matrixFree(Matrix *m);
+
+/* Returns the padded leading dimension used for a row of cols elements. */
+int matrixLeadingDim(int cols);
+
+/* The same padding for elements of elem_size bytes (a power of two <= 64). */
+int matrixLeadingDimSized(int cols, int elem_size);
+
+/* Allocates an uninitialized, aligned rows x cols buffer of elem_size-byte
+ * elements for the kernels in typed.h, stores its leading dimension in *ld
+ * and returns it (release with free), or returns NULL. */
+void *matrixAllocBuffer(int rows, int cols, int elem_size, int *ld);
+
+/* Returns 1 if a and b have the same shape and elements, 0 otherwise. */
+int matrixEqual(const Matrix *a, const Matrix *b);
+
+#endif				// DENSE_H
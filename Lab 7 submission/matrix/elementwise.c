@@ -0,0 +1,25 @@
+#include "elementwise.h"
+
+// GCC generic vector, lowered to whatever SIMD the build target has; may_alias
+// lets it be loaded through an int pointer
+typedef int vint __attribute__((vector_size(EW_LANES * sizeof(int)), may_alias));
+
+// Adds and subtracts one row, EW_LANES elements at a time, then the scalar tail
+void sumDiffRow(const int *a, const int *b, int *sum, int *diff, int n) {
+    const vint *va = (const vint *)a;
+    const vint *vb = (const vint *)b;
+    vint *vs = (vint *)sum;
+    vint *vd = (vint *)diff;
+    int vec = n / EW_LANES;
+
+    for (int j = 0; j < vec; j++) {
+        vint x = va[j];
+        vint y = vb[j];
+        vs[j] = x + y;
+        vd[j] = x - y;
+    }
+    for (int j = vec * EW_LANES; j < n; j++) {
+        sum[j] = a[j] + b[j];
+        diff[j] = a[j] - b[j];
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef ELEMENTWISE_H
+#define ELEMENTWISE_H
+
+/**
+ * Element-wise kernels.
+ *
+ * These passes are bound by memory bandwidth rather than arithmetic, so the
+ * aim is to touch each operand once. Rows of a Matrix start on a 64-byte
+ * boundary (see dense.h), which lets the vector loops use aligned loads.
+ */
+
+/* Lanes per vector: 8 ints = 32 bytes, two per 64-byte row alignment. */
+#define EW_LANES 8
+
+/* sum[j] = a[j] + b[j] and diff[j] = a[j] - b[j] for j in [0, n), in one
+ * sweep over a and b. All four rows must be 32-byte aligned. */
+void sumDiffRow(const int *a, const int *b, int *sum, int *diff, int n);
+
+#endif				// ELEMENTWISE_H
@@ -0,0 +1,309 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dense.h"
+#include "matmul.h"
+#include "elementwise.h"
+#include "threadpool.h"
+#include "strassen.h"
+#include "rng.h"
+#include "transpose.h"
+
+/**
+ * Matrix kernel benchmark.
+ *
+ * Every kernel (the products, the fused sum/difference and the blocked
+ * transpose) runs on square matrices for each size and each pool size of
+ * the sweep. One untimed warm-up run is followed by the timed repetitions,
+ * reported as median and 95th percentile, GFLOP/s at the median, and the
+ * bandwidth needed to read the operands and write the result once. Every
+ * result is compared with a single-threaded naive product (or a plain
+ * loop for the other kernels); any mismatch makes the exit status 1.
+ */
+
+#define MATBENCH_USAGE "usage: ./matbench [-o csv file] [-r reps] [-s n,n,...] [-t threads,threads,...]\n" \
+    "  defaults: 5 reps, sizes 64,128,256,512,1024, threads 1,2,4 ... online CPUs\n"
+
+#define MATBENCH_REPS 5
+#define MATBENCH_MAX_LIST 32
+static const int defaultSizes[] = { 64, 128, 256, 512, 1024 };
+
+// The naive kernel is only timed up to this size (it is still the reference above it)
+#define MATBENCH_NAIVE_MAX 1024
+
+typedef enum {
+    KERNEL_NAIVE, KERNEL_BLOCKED, KERNEL_RECURSIVE, KERNEL_STRASSEN, KERNEL_SUMDIFF,
+    KERNEL_TRANSPOSE, KERNEL_COUNT
+} Kernel;
+
+static const char *kernelNames[KERNEL_COUNT] = {
+    "naive", "blocked", "recursive", "strassen", "sumdiff", "transpose"
+};
+
+// Operands, results and references of one size
+typedef struct {
+    ThreadPool *pool;
+    Matrix *A;
+    Matrix *B;
+    Matrix *C;
+    Matrix *D;
+    Matrix *product;    // naive reference product
+    Matrix *sum;        // reference sum and difference
+    Matrix *diff;
+} Bench;
+
+// Returns the monotonic clock in seconds
+double nowSeconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Naive product of the assigned rows into C
+void runNaive(void* args, int start_row, int end_row) {
+    Bench *b = args;
+
+    matmulNaive(b->A->data, b->A->ld, b->B->data, b->B->ld, b->C->data, b->C->ld,
+                start_row, end_row, b->B->cols, b->A->cols);
+}
+
+// Blocked product of the assigned rows into C
+void runBlocked(void* args, int start_row, int end_row) {
+    Bench *b = args;
+
+    matmulBlocked(b->A->data, b->A->ld, b->B->data, b->B->ld, b->C->data, b->C->ld,
+                  start_row, end_row, b->B->cols, b->A->cols);
+}
+
+// Fused sum and difference of the assigned rows into C and D
+void runSumDiff(void* args, int start_row, int end_row) {
+    Bench *b = args;
+
+    for(int i = start_row; i < end_row; i++) {
+        sumDiffRow(&MAT(b->A, i, 0), &MAT(b->B, i, 0), &MAT(b->C, i, 0), &MAT(b->D, i, 0),
+                   b->A->cols);
+    }
+}
+
+// Runs one kernel once and returns the elapsed time in seconds
+double runKernel(Bench *b, Kernel kernel) {
+    int n = b->A->rows;
+    double start = nowSeconds();
+
+    switch (kernel) {
+    case KERNEL_NAIVE:
+        poolParallelFor(b->pool, runNaive, b, n);
+        break;
+    case KERNEL_BLOCKED:
+        poolParallelFor(b->pool, runBlocked, b, n);
+        break;
+    case KERNEL_RECURSIVE:
+        matmulRecursive(b->pool, b->A->data, b->A->ld, b->B->data, b->B->ld,
+                        b->C->data, b->C->ld, n, n, n);
+        break;
+    case KERNEL_STRASSEN:
+        matmulStrassen(b->pool, b->A->data, b->A->ld, b->B->data, b->B->ld,
+                       b->C->data, b->C->ld, n, n, n, STRASSEN_CROSSOVER);
+        break;
+    case KERNEL_SUMDIFF:
+        poolParallelFor(b->pool, runSumDiff, b, n);
+        break;
+    default:
+        matrixTranspose(b->pool, b->A, b->C);
+        break;
+    }
+    return nowSeconds() - start;
+}
+
+// Checks the output of the last run of a kernel against the references
+int checkKernel(const Bench *b, Kernel kernel) {
+    if (kernel == KERNEL_SUMDIFF) {
+        return matrixEqual(b->C, b->sum) && matrixEqual(b->D, b->diff);
+    }
+    if (kernel == KERNEL_TRANSPOSE) {
+        for(int i = 0; i < b->A->rows; i++) {
+            for(int j = 0; j < b->A->cols; j++) {
+                if (MAT(b->C, j, i) != MAT(b->A, i, j)) {
+                    return 0;
+                }
+            }
+        }
+        return 1;
+    }
+    return matrixEqual(b->C, b->product);
+}
+
+// qsort comparison of two doubles
+int compareDoubles(const void* x, const void* y) {
+    double a = *(const double*)x, b = *(const double*)y;
+
+    return (a > b) - (a < b);
+}
+
+// Parses a comma-separated list of positive ints; returns the count, or -1
+int parseList(const char* text, int* list) {
+    int count = 0;
+
+    while (*text != '\0') {
+        char *end;
+        long v = strtol(text, &end, 10);
+
+        if (end == text || v <= 0 || v > 1 << 20 || count == MATBENCH_MAX_LIST ||
+            (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        list[count++] = (int)v;
+        text = *end == ',' ? end + 1 : end;
+    }
+    return count > 0 ? count : -1;
+}
+
+// Allocates and fills the operands of one size and computes the references
+int benchSetup(Bench *b, int n) {
+    b->A = matrixAlloc(n, n);
+    b->B = matrixAlloc(n, n);
+    b->C = matrixAlloc(n, n);
+    b->D = matrixAlloc(n, n);
+    b->product = matrixAlloc(n, n);
+    b->sum = matrixAlloc(n, n);
+    b->diff = matrixAlloc(n, n);
+    if (!b->A || !b->B || !b->C || !b->D || !b->product || !b->sum || !b->diff) {
+        return -1;
+    }
+    for(int i = 0; i < n; i++) {
+        rngFillRow(&MAT(b->A, i, 0), n, rngStream(0, 1), (uint64_t)i * n, 1, 10);
+        rngFillRow(&MAT(b->B, i, 0), n, rngStream(0, 2), (uint64_t)i * n, 1, 10);
+        for(int j = 0; j < n; j++) {
+            MAT(b->sum, i, j) = MAT(b->A, i, j) + MAT(b->B, i, j);
+            MAT(b->diff, i, j) = MAT(b->A, i, j) - MAT(b->B, i, j);
+        }
+    }
+    matmulNaive(b->A->data, b->A->ld, b->B->data, b->B->ld, b->product->data, b->product->ld,
+                0, n, n, n);
+    return 0;
+}
+
+void benchFree(Bench *b) {
+    matrixFree(b->A);
+    matrixFree(b->B);
+    matrixFree(b->C);
+    matrixFree(b->D);
+    matrixFree(b->product);
+    matrixFree(b->sum);
+    matrixFree(b->diff);
+}
+
+int main(int argc, char *argv[]) {
+    int sizes[MATBENCH_MAX_LIST], threads[MATBENCH_MAX_LIST];
+    int nsizes = sizeof(defaultSizes) / sizeof(defaultSizes[0]), nthreads = 0;
+    int reps = MATBENCH_REPS, status = 0;
+    const char *csv_path = NULL;
+    FILE *csv = NULL;
+    double *times;
+
+    memcpy(sizes, defaultSizes, sizeof(defaultSizes));
+    for (int t = 1; t < poolDefaultThreads(); t *= 2) {
+        threads[nthreads++] = t;
+    }
+    threads[nthreads++] = poolDefaultThreads();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            nsizes = parseList(argv[++i], sizes);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            nthreads = parseList(argv[++i], threads);
+        } else {
+            nsizes = -1;
+        }
+        if (nsizes < 0 || nthreads < 0) {
+            printf(MATBENCH_USAGE);
+            return 1;
+        }
+    }
+
+    times = malloc(reps * sizeof(double));
+    if (times == NULL) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            printf("Error: cannot write %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "kernel,n,threads,reps,median_ms,p95_ms,gflops,gbps,correct\n");
+    }
+
+    printf("%-10s %6s %7s %11s %11s %9s %8s  %s\n", "kernel", "n", "threads",
+           "median ms", "p95 ms", "GFLOP/s", "GB/s", "check");
+    for (int s = 0; s < nsizes; s++) {
+        int n = sizes[s];
+        Bench b = { NULL };
+
+        if (benchSetup(&b, n) != 0) {
+            printf("Error: cannot allocate %dx%d matrices\n", n, n);
+            benchFree(&b);
+            status = 1;
+            continue;
+        }
+        for (int t = 0; t < nthreads; t++) {
+            b.pool = poolCreate(threads[t], 0);
+            if (b.pool == NULL) {
+                printf("Error: cannot start %d worker threads\n", threads[t]);
+                status = 1;
+                continue;
+            }
+            for (int k = 0; k < KERNEL_COUNT; k++) {
+                if (k == KERNEL_NAIVE && n > MATBENCH_NAIVE_MAX) {
+                    continue;
+                }
+                // Products read A and B and write C, the fused pass also writes D,
+                // and the transpose only reads A and writes C (and does no arithmetic)
+                double flops = k == KERNEL_TRANSPOSE ? 0.0 : k == KERNEL_SUMDIFF ? 2.0 * n * n
+                             : 2.0 * n * n * n;
+                double bytes = (k == KERNEL_SUMDIFF ? 4.0 : k == KERNEL_TRANSPOSE ? 2.0 : 3.0)
+                             * n * n * sizeof(int);
+                int correct;
+
+                runKernel(&b, k);
+                correct = checkKernel(&b, k);
+                for (int r = 0; r < reps; r++) {
+                    times[r] = runKernel(&b, k);
+                }
+                correct = correct && checkKernel(&b, k);
+                status |= !correct;
+                qsort(times, reps, sizeof(double), compareDoubles);
+
+                // Median and nearest-rank 95th percentile
+                double median = reps % 2 ? times[reps / 2] : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+                double p95 = times[(int)((95L * reps + 99) / 100) - 1];
+
+                printf("%-10s %6d %7d %11.3f %11.3f %9.3f %8.3f  %s\n", kernelNames[k], n,
+                       b.pool->nthreads, median * 1e3, p95 * 1e3, flops / median * 1e-9,
+                       bytes / median * 1e-9, correct ? "ok" : "WRONG");
+                if (csv != NULL) {
+                    fprintf(csv, "%s,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%d\n", kernelNames[k], n,
+                            b.pool->nthreads, reps, median * 1e3, p95 * 1e3,
+                            flops / median * 1e-9, bytes / median * 1e-9, correct);
+                }
+                fflush(stdout);
+            }
+            poolDestroy(b.pool);
+        }
+        benchFree(&b);
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    free(times);
+    return status;
+}
@@ -0,0 +1,89 @@
+#include <string.h>
+#include "matmul.h"
+
+// Computes rows [row_start, row_end) of C = A * B with the naive i-j-k loop
+void matmulNaive(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                 int row_start, int row_end, int n, int k) {
+    for (int i = row_start; i < row_end; i++) {
+        for (int j = 0; j < n; j++) {
+            int sum = 0;
+            for (int p = 0; p < k; p++) {
+                sum += A[(size_t)i * lda + p] * B[(size_t)p * ldb + j];
+            }
+            C[(size_t)i * ldc + j] = sum;
+        }
+    }
+}
+
+// Adds A[i0..i0+3][k0..k1) * B[k0..k1)[j0..j1) into four rows of C
+static void tile4x(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                   int i0, int k0, int k1, int j0, int j1) {
+    int *restrict c0 = C + (size_t)(i0 + 0) * ldc;
+    int *restrict c1 = C + (size_t)(i0 + 1) * ldc;
+    int *restrict c2 = C + (size_t)(i0 + 2) * ldc;
+    int *restrict c3 = C + (size_t)(i0 + 3) * ldc;
+
+    for (int p = k0; p < k1; p++) {
+        const int *restrict b = B + (size_t)p * ldb;
+        int a0 = A[(size_t)(i0 + 0) * lda + p];
+        int a1 = A[(size_t)(i0 + 1) * lda + p];
+        int a2 = A[(size_t)(i0 + 2) * lda + p];
+        int a3 = A[(size_t)(i0 + 3) * lda + p];
+
+        for (int j = j0; j < j1; j++) {
+            int bj = b[j];
+            c0[j] += a0 * bj;
+            c1[j] += a1 * bj;
+            c2[j] += a2 * bj;
+            c3[j] += a3 * bj;
+        }
+    }
+}
+
+// Adds A[i][k0..k1) * B[k0..k1)[j0..j1) into one row of C
+static void tile1x(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                   int i, int k0, int k1, int j0, int j1) {
+    int *restrict c = C + (size_t)i * ldc;
+
+    for (int p = k0; p < k1; p++) {
+        const int *restrict b = B + (size_t)p * ldb;
+        int a = A[(size_t)i * lda + p];
+
+        for (int j = j0; j < j1; j++) {
+            c[j] += a * b[j];
+        }
+    }
+}
+
+// Computes rows [row_start, row_end) of C = A * B one cache block at a time
+void matmulBlocked(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                   int row_start, int row_end, int n, int k) {
+    for (int i = row_start; i < row_end; i++) {
+        memset(C + (size_t)i * ldc, 0, n * sizeof(int));
+    }
+    matmulBlockedAdd(A, lda, B, ldb, C, ldc, row_start, row_end, n, k);
+}
+
+// Adds rows [row_start, row_end) of A * B into C one cache block at a time
+void matmulBlockedAdd(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                      int row_start, int row_end, int n, int k) {
+    for (int jj = 0; jj < n; jj += TILE_J) {
+        int j1 = jj + TILE_J < n ? jj + TILE_J : n;
+
+        for (int kk = 0; kk < k; kk += TILE_K) {
+            int k1 = kk + TILE_K < k ? kk + TILE_K : k;
+
+            for (int ii = row_start; ii < row_end; ii += TILE_I) {
+                int i1 = ii + TILE_I < row_end ? ii + TILE_I : row_end;
+                int i = ii;
+
+                for (; i + 4 <= i1; i += 4) {
+                    tile4x(A, lda, B, ldb, C, ldc, i, kk, k1, jj, j1);
+                }
+                for (; i < i1; i++) {
+                    tile1x(A, lda, B, ldb, C, ldc, i, kk, k1, jj, j1);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef MATMUL_H
+#define MATMUL_H
+
+/**
+ * Integer matrix multiply kernels.
+ *
+ * Matrices are row-major with a leading dimension (elements between the
+ * starts of consecutive rows), so the same kernels work on sub-blocks and
+ * padded buffers. Each kernel computes rows [row_start, row_end) of
+ * C = A * B, where A is m x k and B is k x n; threads split the work by
+ * giving each call a different row range.
+ */
+
+/* Cache blocking for matmulBlocked: a TILE_K x TILE_J panel of B (128 KiB
+ * of ints) stays in L2 while TILE_I rows of A stream past it. */
+#define TILE_I 64
+#define TILE_K 128
+#define TILE_J 256
+
+/* Textbook i-j-k order; the inner loop walks B down a column. */
+void matmulNaive(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                 int row_start, int row_end, int n, int k);
+
+/* Blocked i-k-j order with a 4-row register tile: each row of a B panel is
+ * loaded once per four rows of C, and every inner loop is unit stride. */
+void matmulBlocked(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                   int row_start, int row_end, int n, int k);
+
+/* matmulBlocked that adds A * B into C instead of overwriting it. */
+void matmulBlockedAdd(const int *A, int lda, const int *B, int ldb, int *C, int ldc,
+                      int row_start, int row_end, int n, int k);
+
+#endif				// MATMUL_H
@@ -1,164 +1,1214 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <time.h>
+#include "dense.h"
+#include "matmul.h"
+#include "elementwise.h"
+#include "threadpool.h"
+#include "strassen.h"
+#include "typed.h"
+#include "rng.h"
+#include "matrixio.h"
+#include "sparse.h"
+#include "batch.h"
+#include "transpose.h"
 
-#define MAX 20
+#define USAGE "usage: ./matrix [-o] [-p] [-q | -P] [-a file] [-b file] [-w file] [-r seed]\n" \
+    "                [-t threads] [-s crossover] [n | m k n]\n" \
+    "       ./matrix -c [-p] [-r seed] [-t threads] [max n]\n" \
+    "       ./matrix -T [-p] [-r seed] [-t threads] [n]\n" \
+    "       ./matrix -S [-p] [-r seed] [-t threads] [n [percent]]\n" \
+    "       ./matrix -B [-p] [-r seed] [-t threads] [count [n]]\n" \
+    "  A is m x k and B is k x n (default 20 x 20); sum and difference need m = k = n\n" \
+    "  -a  load A from a binary or text matrix file instead of filling it randomly\n" \
+    "  -b  load B likewise; the sizes of loaded operands override m, k and n\n" \
+    "  -w  store the product (text if the name ends in .txt, binary otherwise)\n" \
+    "  -q  print no matrices\n" \
+    "  -P  print matrices of any size (default: up to 20 x 20)\n" \
+    "  -o  overlap the fused sum/difference pass with the blocked product\n" \
+    "  -p  pin each worker thread to its own CPU\n" \
+    "  -r  random seed; a seed gives the same matrices for any thread count\n" \
+    "  -t  worker threads (default: online CPUs)\n" \
+    "  -s  size below which Strassen switches to the recursive multiply\n" \
+    "  -c  time every product kernel on square sizes up to max n (default 1024)\n" \
+    "  -T  compare the element types on n x n matrices (default 512), then check the\n" \
+    "      overflow-safe int32 products on full-range values\n" \
+    "  -S  run the sparse (CSR) kernels on n x n matrices with the given percentage\n" \
+    "      of nonzeros (default 1024, 1%%) and check them against the dense ones\n" \
+    "  -B  multiply and add a batch of count n x n matrices (default 20000 of 20 x 20)\n"
 
-int matA[MAX][MAX]; 
-int matB[MAX][MAX]; 
+// Sizes and crossovers tried by the -c sweep; naive is skipped above SWEEP_NAIVE_MAX
+#define SWEEP_MIN 128
+#define SWEEP_NAIVE_MAX 1024
+static const int sweepCrossovers[] = { 64, 128, 256, 512 };
 
-int matSumResult[MAX][MAX];
-int matDiffResult[MAX][MAX]; 
-int matProductResult[MAX][MAX]; 
+// Size, value range and checked entries of the -T element type comparison.
+// Values up to 2^15 make int32 products overflow but stay exact in float.
+#define TYPED_DEFAULT_SIZE 512
+#define TYPED_VALUE_MAX (1 << 15)
+#define TYPED_SAMPLES 64
 
-// Structure to store arguments for each thread, including thread ID and the range of rows it will process
+// Shapes of the -T full-range check, m x k times k x n: two full-range int32
+// products already overflow int64, and the deepest k spans several TILE_K slices
+#define TYPED_FULL_M 6
+#define TYPED_FULL_N 11
+static const int typedFullDepths[] = { 1, 2, 3, 4, 17, 300 };
+static const int32_t typedExtremes[] = {
+    INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX - 1, INT32_MAX
+};
+
+// Default size and percentage of nonzeros of the -S sparse run; the
+// percentage is resolved to 1 / SPARSE_SCALE
+#define SPARSE_DEFAULT_SIZE 1024
+#define SPARSE_DEFAULT_PERCENT 1.0
+#define SPARSE_SCALE (1 << 20)
+
+// Default batch of the -B run: many matrices of the default size
+#define BATCH_DEFAULT_COUNT 20000
+
+// Random streams of the operands, so A and B differ under one seed
+#define STREAM_A 1
+#define STREAM_B 2
+#define STREAM_SAMPLES 3
+#define STREAM_VECTOR 4
+
+// Default matrix size
+#define DEFAULT_SIZE 20
+
+// Matrices larger than this are not printed unless -P is given
+#define PRINT_LIMIT 20
+
+// Which matrices printMatrix shows
+enum { PRINT_NONE, PRINT_SMALL, PRINT_ALL };
+int print_mode = PRINT_SMALL;
+
+Matrix *matA;
+Matrix *matB;
+
+Matrix *matSumResult;
+Matrix *matDiffResult;
+Matrix *matSumFused;
+Matrix *matDiffFused;
+Matrix *matProductResult;
+Matrix *matBlockedResult;
+Matrix *matRecursiveResult;
+Matrix *matTransposed;
+
+// Seed of every random matrix (-r, default: the time)
+uint64_t seed;
+
+// Strassen crossover size
+int crossover = STRASSEN_CROSSOVER;
+
+// Workers shared by every operation, created once in main
+ThreadPool *pool;
+
+// One matrix being filled by the workers from one random stream
 typedef struct {
-    int thread_id;
-    int start_row;
-    int end_row;
-} ThreadArgs;
+    Matrix *matrix;
+    uint64_t stream;
+} FillJob;
 
-// Fills a matrix with random integers between 1 and 10
-void fillMatrix(int matrix[MAX][MAX]) {
-    for(int i = 0; i < MAX; i++) {
-        for(int j = 0; j < MAX; j++) {
-            matrix[i][j] = rand() % 10 + 1;
-        }
+// Fills the assigned rows with random integers between 1 and 10; element
+// (i, j) is value number i * cols + j of the stream, whoever computes it
+void computeFill(void* args, int start_row, int end_row) {
+    FillJob *job = args;
+
+    for(int i = start_row; i < end_row; i++) {
+        rngFillRow(&MAT(job->matrix, i, 0), job->matrix->cols, job->stream,
+                   (uint64_t)i * job->matrix->cols, 1, 10);
     }
 }
 
-// Prints the contents of a matrix in a formatted layout
-void printMatrix(int matrix[MAX][MAX]) {
-    for(int i = 0; i < MAX; i++) {
-        for(int j = 0; j < MAX; j++) {
-            printf("%5d", matrix[i][j]);
+// Fills a matrix from random stream id in parallel; the workers first-touch
+// the rows they fill
+void fillMatrix(Matrix *matrix, int id) {
+    FillJob job = { matrix, rngStream(seed, id) };
+
+    poolParallelFor(pool, computeFill, &job, matrix->rows);
+}
+
+// A matrix being filled with mostly zeros from one random stream
+typedef struct {
+    Matrix *matrix;
+    uint64_t stream;
+    int threshold;      // nonzero when a draw in [0, SPARSE_SCALE) falls below this
+} SparseFillJob;
+
+// Makes each element of the assigned rows nonzero (1 to 10) with probability
+// threshold / SPARSE_SCALE; like computeFill, the result depends only on the seed
+void computeSparseFill(void* args, int start_row, int end_row) {
+    SparseFillJob *job = args;
+
+    for(int i = start_row; i < end_row; i++) {
+        for(int j = 0; j < job->matrix->cols; j++) {
+            uint64_t e = (uint64_t)i * job->matrix->cols + j;
+
+            MAT(job->matrix, i, j) = rngInt(job->stream, 2 * e, 0, SPARSE_SCALE - 1) < job->threshold
+                                     ? rngInt(job->stream, 2 * e + 1, 1, 10) : 0;
         }
-        printf("\n");
     }
+}
+
+// Prints the title and contents of a matrix in a formatted layout
+void printMatrix(const char* title, Matrix *matrix) {
+    if (print_mode == PRINT_NONE) {
+        return;
+    }
+    printf("%s\n", title);
+    if (print_mode == PRINT_SMALL && (matrix->rows > PRINT_LIMIT || matrix->cols > PRINT_LIMIT)) {
+        printf("(%dx%d, not printed)\n\n", matrix->rows, matrix->cols);
+        return;
+    }
+    matrixWriteText(matrix, stdout);
     printf("\n");
 }
 
+// Returns 1 if path ends in ".txt"
+int isTextPath(const char* path) {
+    size_t len = strlen(path);
+
+    return len >= 4 && strcmp(path + len - 4, ".txt") == 0;
+}
+
+// Zeroes the assigned rows of the matrix in args, so the worker that will
+// later process those rows is the one that first touches their pages
+void computeTouch(void* args, int start_row, int end_row) {
+    Matrix *matrix = args;
+
+    for(int i = start_row; i < end_row; i++) {
+        memset(&MAT(matrix, i, 0), 0, matrix->cols * sizeof(int));
+    }
+}
+
 // Computes the sum of corresponding elements in two matrices for the assigned rows
-void* computeSum(void* args) {
-    ThreadArgs* thread_args = (ThreadArgs*)args;
-    int start_row = thread_args->start_row;
-    int end_row = thread_args->end_row;
-    
+void computeSum(void* args, int start_row, int end_row) {
     // Loops through the assigned rows to calculate the sum
     for(int i = start_row; i < end_row; i++) {
-        for(int j = 0; j < MAX; j++) {
-            matSumResult[i][j] = matA[i][j] + matB[i][j];
+        for(int j = 0; j < matA->cols; j++) {
+            MAT(matSumResult, i, j) = MAT(matA, i, j) + MAT(matB, i, j);
         }
     }
-    
-    free(args);  // Frees the allocated memory for thread arguments
-    return NULL;
 }
 
 // Computes the difference between corresponding elements in two matrices for the assigned rows
-void* computeDiff(void* args) {
-    ThreadArgs* thread_args = (ThreadArgs*)args;
-    int start_row = thread_args->start_row;
-    int end_row = thread_args->end_row;
-    
+void computeDiff(void* args, int start_row, int end_row) {
     // Loops through the assigned rows to calculate the difference
     for(int i = start_row; i < end_row; i++) {
-        for(int j = 0; j < MAX; j++) {
-            matDiffResult[i][j] = matA[i][j] - matB[i][j];
+        for(int j = 0; j < matA->cols; j++) {
+            MAT(matDiffResult, i, j) = MAT(matA, i, j) - MAT(matB, i, j);
         }
     }
-    
-    free(args);  // Frees the allocated memory for thread arguments
-    return NULL;
+}
+
+// Computes the sum and difference for the assigned rows in one vectorized sweep
+void computeSumDiff(void* args, int start_row, int end_row) {
+    for(int i = start_row; i < end_row; i++) {
+        sumDiffRow(&MAT(matA, i, 0), &MAT(matB, i, 0),
+                   &MAT(matSumFused, i, 0), &MAT(matDiffFused, i, 0), matA->cols);
+    }
 }
 
 // Computes the product of two matrices for the assigned rows
-void* computeProduct(void* args) {
-    ThreadArgs* thread_args = (ThreadArgs*)args;
-    int start_row = thread_args->start_row;
-    int end_row = thread_args->end_row;
-    
+void computeProduct(void* args, int start_row, int end_row) {
     // Loops through the assigned rows to calculate the product
-    for(int i = start_row; i < end_row; i++) {
-        for(int j = 0; j < MAX; j++) {
-            matProductResult[i][j] = 0;  // Initialize result to zero
-            for(int k = 0; k < MAX; k++) {
-                matProductResult[i][j] += matA[i][k] * matB[k][j];
+    matmulNaive(matA->data, matA->ld, matB->data, matB->ld,
+                matProductResult->data, matProductResult->ld,
+                start_row, end_row, matB->cols, matA->cols);
+}
+
+// Computes the product for the assigned rows with the cache-blocked kernel
+void computeProductBlocked(void* args, int start_row, int end_row) {
+    matmulBlocked(matA->data, matA->ld, matB->data, matB->ld,
+                  matBlockedResult->data, matBlockedResult->ld,
+                  start_row, end_row, matB->cols, matA->cols);
+}
+
+// Returns the monotonic clock in seconds
+double nowSeconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Prints the time and throughput of one m x k x n product
+void reportProduct(const char* name, double seconds) {
+    double flops = 2.0 * matA->rows * matA->cols * matB->cols;
+
+    printf("%-16s %10.3f ms  %8.3f GFLOP/s\n", name, seconds * 1e3,
+           seconds > 0 ? flops / seconds * 1e-9 : 0.0);
+}
+
+// Places a freshly allocated matrix by having the workers first-touch their rows
+void touchMatrix(Matrix *matrix) {
+    if (matrix != NULL) {
+        poolParallelFor(pool, computeTouch, matrix, matrix->rows);
+    }
+}
+
+// Prints how long each worker spent running tasks in one saved snapshot of the pool counters
+void reportWorkers(const char* name, const WorkerStats* snapshot) {
+    printf("%s per worker:\n", name);
+    for (int w = 0; w < pool->nthreads; w++) {
+        const WorkerStats *stats = &snapshot[w];
+
+        if (stats->cpu >= 0) {
+            printf("  worker %2d (cpu %3d) %10.3f ms  %4ld tiles\n", w, stats->cpu,
+                   stats->busy * 1e3, stats->tasks);
+        } else {
+            printf("  worker %2d %20.3f ms  %4ld tiles\n", w, stats->busy * 1e3, stats->tasks);
+        }
+    }
+}
+
+// Runs routine over rows on the worker pool and returns the elapsed time in seconds
+double runThreads(RangeFn routine, int rows) {
+    double start = nowSeconds();
+
+    poolParallelFor(pool, routine, NULL, rows);
+    return nowSeconds() - start;
+}
+
+// Times the recursive multiply (or Strassen when use_strassen) into matRecursiveResult
+double runRecursive(int use_strassen, int cutoff) {
+    double start = nowSeconds();
+
+    if (use_strassen) {
+        matmulStrassen(pool, matA->data, matA->ld, matB->data, matB->ld,
+                       matRecursiveResult->data, matRecursiveResult->ld,
+                       matA->rows, matB->cols, matA->cols, cutoff);
+    } else {
+        matmulRecursive(pool, matA->data, matA->ld, matB->data, matB->ld,
+                        matRecursiveResult->data, matRecursiveResult->ld,
+                        matA->rows, matB->cols, matA->cols);
+    }
+    return nowSeconds() - start;
+}
+
+// Element types and accumulations compared by the -T mode
+typedef enum {
+    TYPE_I32, TYPE_I64, TYPE_F32, TYPE_F64, TYPE_WIDEN, TYPE_SATURATE, TYPE_COUNT
+} ElemType;
+
+static const char *typeNames[TYPE_COUNT] = {
+    "int32 (wraps)", "int64", "float", "double", "int32 -> int64", "int32 saturated"
+};
+
+// One typed n x n operation for the workers: C = A * B, or C = A + B and D = A - B
+typedef struct {
+    ElemType type;
+    int sumdiff;
+    const void *A;
+    const void *B;
+    void *C;
+    void *D;
+    int ld;         // leading dimension of A and B
+    int ldc;        // leading dimension of C and D
+    int n;
+    int failed;     // set by a task that could not allocate its scratch space
+} TypedJob;
+
+// Runs the assigned rows of a typed job with the kernel specialized for its type
+void computeTyped(void* args, int start_row, int end_row) {
+    TypedJob *job = args;
+
+    if (job->sumdiff) {
+        for (int i = start_row; i < end_row; i++) {
+            size_t a = (size_t)i * job->ld, c = (size_t)i * job->ldc;
+
+            switch (job->type) {
+            case TYPE_I32:
+                sumDiffRowI32((const int32_t *)job->A + a, (const int32_t *)job->B + a,
+                              (int32_t *)job->C + c, (int32_t *)job->D + c, job->n);
+                break;
+            case TYPE_I64:
+                sumDiffRowI64((const int64_t *)job->A + a, (const int64_t *)job->B + a,
+                              (int64_t *)job->C + c, (int64_t *)job->D + c, job->n);
+                break;
+            case TYPE_F32:
+                sumDiffRowF32((const float *)job->A + a, (const float *)job->B + a,
+                              (float *)job->C + c, (float *)job->D + c, job->n);
+                break;
+            default:
+                sumDiffRowF64((const double *)job->A + a, (const double *)job->B + a,
+                              (double *)job->C + c, (double *)job->D + c, job->n);
+                break;
             }
         }
+        return;
+    }
+    switch (job->type) {
+    case TYPE_I32:
+        matmulBlockedI32(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                         start_row, end_row, job->n, job->n);
+        break;
+    case TYPE_I64:
+        matmulBlockedI64(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                         start_row, end_row, job->n, job->n);
+        break;
+    case TYPE_F32:
+        matmulBlockedF32(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                         start_row, end_row, job->n, job->n);
+        break;
+    case TYPE_F64:
+        matmulBlockedF64(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                         start_row, end_row, job->n, job->n);
+        break;
+    case TYPE_WIDEN:
+        matmulWidenI32(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                       start_row, end_row, job->n, job->n);
+        break;
+    default:
+        if (matmulSaturateI32(job->A, job->ld, job->B, job->ld, job->C, job->ldc,
+                              start_row, end_row, job->n, job->n) != 0) {
+            __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        }
+        break;
     }
-    
-    free(args);  // Frees the allocated memory for thread arguments
-    return NULL;
 }
 
-int main() {
-    srand(time(0));  // Seed the random number generator
-    
-    // Fill matrices A and B with random values
-    fillMatrix(matA);
-    fillMatrix(matB);
+// Reads element i of a typed buffer as a double
+double typedValue(ElemType type, const void *data, size_t i) {
+    switch (type) {
+    case TYPE_I32:
+    case TYPE_SATURATE:
+        return ((const int32_t *)data)[i];
+    case TYPE_F32:
+        return ((const float *)data)[i];
+    case TYPE_F64:
+        return ((const double *)data)[i];
+    default:
+        return (double)((const int64_t *)data)[i];
+    }
+}
+
+// Checks the widening and saturating int32 products against exact 128-bit sums on
+// operands that are all INT32_MIN, all INT32_MAX, or a mix of extreme values
+int typedFullRangeCheck(void) {
+    int ndepths = sizeof(typedFullDepths) / sizeof(typedFullDepths[0]);
+    int m = TYPED_FULL_M, n = TYPED_FULL_N, checked = 0, wrong = 0;
+
+    for (int d = 0; d < ndepths; d++) {
+        int k = typedFullDepths[d];
+        int32_t *A = malloc((size_t)m * k * sizeof(int32_t));
+        int32_t *B = malloc((size_t)k * n * sizeof(int32_t));
+        int64_t *wide = malloc((size_t)m * n * sizeof(int64_t));
+        int32_t *saturated = malloc((size_t)m * n * sizeof(int32_t));
+
+        if (A == NULL || B == NULL || wide == NULL || saturated == NULL) {
+            printf("Error: out of memory\n");
+            free(A);
+            free(B);
+            free(wide);
+            free(saturated);
+            return 1;
+        }
+        for (int pattern = 0; pattern < 3; pattern++) {
+            for (int i = 0; i < m * k; i++) {
+                A[i] = pattern == 0 ? INT32_MIN : pattern == 1 ? INT32_MAX : typedExtremes[i * 5 % 7];
+            }
+            for (int i = 0; i < k * n; i++) {
+                B[i] = pattern == 0 ? INT32_MIN : pattern == 1 ? INT32_MAX : typedExtremes[(i * 3 + 1) % 7];
+            }
+            matmulWidenI32(A, k, B, n, wide, n, 0, m, n, k);
+            if (matmulSaturateI32(A, k, B, n, saturated, n, 0, m, n, k) != 0) {
+                printf("Error: out of memory\n");
+                wrong++;
+                break;
+            }
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) {
+                    __int128 exact = 0;
+
+                    for (int p = 0; p < k; p++) {
+                        exact += (int64_t)A[(size_t)i * k + p] * B[(size_t)p * n + j];
+                    }
+                    int64_t want64 = exact > INT64_MAX ? INT64_MAX : exact < INT64_MIN ? INT64_MIN : (int64_t)exact;
+                    int32_t want32 = exact > INT32_MAX ? INT32_MAX : exact < INT32_MIN ? INT32_MIN : (int32_t)exact;
+
+                    wrong += wide[(size_t)i * n + j] != want64 || saturated[(size_t)i * n + j] != want32;
+                    checked++;
+                }
+            }
+        }
+        free(A);
+        free(B);
+        free(wide);
+        free(saturated);
+    }
+
+    printf("Full-range int32 operands (k up to %d): %d/%d widened and saturated entries exact\n",
+           typedFullDepths[ndepths - 1], checked - wrong, checked);
+    if (wrong > 0) {
+        printf("Error: the widening or saturating product is wrong on full-range values\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Times the blocked product and the fused sum/difference in every element type
+// on the same n x n int32 inputs, and checks sampled entries against exact sums
+int typeSweep(int n) {
+    int ld32, ld64, ldf, ldd, ldc32, ldc64, ldcf, ldcd;
+    void *in[TYPE_COUNT][2], *out[TYPE_COUNT][2];
+    int ld[TYPE_COUNT], ldc[TYPE_COUNT];
+    int si[TYPED_SAMPLES], sj[TYPED_SAMPLES];
+    int64_t exact[TYPED_SAMPLES];
+    void *buffers[16];
+    int nbuffers = 0, status = 0;
+
+    // int32 wraps and saturates from one set of int32 buffers, int64 and the
+    // widening kernel share the int64 outputs
+    int32_t *a32 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int32_t), &ld32);
+    int32_t *b32 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int32_t), &ld32);
+    int64_t *a64 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int64_t), &ld64);
+    int64_t *b64 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int64_t), &ld64);
+    float *af = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(float), &ldf);
+    float *bf = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(float), &ldf);
+    double *ad = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(double), &ldd);
+    double *bd = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(double), &ldd);
+    void *c32 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int32_t), &ldc32);
+    void *d32 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int32_t), &ldc32);
+    void *c64 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int64_t), &ldc64);
+    void *d64 = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(int64_t), &ldc64);
+    void *cf = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(float), &ldcf);
+    void *df = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(float), &ldcf);
+    void *cd = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(double), &ldcd);
+    void *dd = buffers[nbuffers++] = matrixAllocBuffer(n, n, sizeof(double), &ldcd);
+    for (int b = 0; b < nbuffers; b++) {
+        if (buffers[b] == NULL) {
+            printf("Error: cannot allocate %dx%d matrices\n", n, n);
+            for (int f = 0; f < nbuffers; f++) {
+                free(buffers[f]);
+            }
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        rngFillRow(a32 + (size_t)i * ld32, n, rngStream(seed, STREAM_A), (uint64_t)i * n,
+                   -TYPED_VALUE_MAX, TYPED_VALUE_MAX);
+        rngFillRow(b32 + (size_t)i * ld32, n, rngStream(seed, STREAM_B), (uint64_t)i * n,
+                   -TYPED_VALUE_MAX, TYPED_VALUE_MAX);
+        for (int j = 0; j < n; j++) {
+            size_t e = (size_t)i * ld32 + j;
+            a64[(size_t)i * ld64 + j] = a32[e];
+            b64[(size_t)i * ld64 + j] = b32[e];
+            af[(size_t)i * ldf + j] = a32[e];
+            bf[(size_t)i * ldf + j] = b32[e];
+            ad[(size_t)i * ldd + j] = a32[e];
+            bd[(size_t)i * ldd + j] = b32[e];
+        }
+    }
+    for (int s = 0; s < TYPED_SAMPLES; s++) {
+        si[s] = rngInt(rngStream(seed, STREAM_SAMPLES), 2 * s, 0, n - 1);
+        sj[s] = rngInt(rngStream(seed, STREAM_SAMPLES), 2 * s + 1, 0, n - 1);
+        exact[s] = 0;
+        for (int p = 0; p < n; p++) {
+            exact[s] += (int64_t)a32[(size_t)si[s] * ld32 + p] * b32[(size_t)p * ld32 + sj[s]];
+        }
+    }
+
+    in[TYPE_I32][0] = in[TYPE_WIDEN][0] = in[TYPE_SATURATE][0] = a32;
+    in[TYPE_I32][1] = in[TYPE_WIDEN][1] = in[TYPE_SATURATE][1] = b32;
+    ld[TYPE_I32] = ld[TYPE_WIDEN] = ld[TYPE_SATURATE] = ld32;
+    in[TYPE_I64][0] = a64, in[TYPE_I64][1] = b64, ld[TYPE_I64] = ld64;
+    in[TYPE_F32][0] = af, in[TYPE_F32][1] = bf, ld[TYPE_F32] = ldf;
+    in[TYPE_F64][0] = ad, in[TYPE_F64][1] = bd, ld[TYPE_F64] = ldd;
+    out[TYPE_I32][0] = out[TYPE_SATURATE][0] = c32;
+    out[TYPE_I32][1] = d32, ldc[TYPE_I32] = ldc[TYPE_SATURATE] = ldc32;
+    out[TYPE_I64][0] = out[TYPE_WIDEN][0] = c64;
+    out[TYPE_I64][1] = d64, ldc[TYPE_I64] = ldc[TYPE_WIDEN] = ldc64;
+    out[TYPE_F32][0] = cf, out[TYPE_F32][1] = df, ldc[TYPE_F32] = ldcf;
+    out[TYPE_F64][0] = cd, out[TYPE_F64][1] = dd, ldc[TYPE_F64] = ldcd;
+
+    printf("Element types (%dx%d, values in +-%d, %d threads):\n",
+           n, n, TYPED_VALUE_MAX, pool->nthreads);
+    printf("%-16s %10s %10s %13s %16s\n", "type", "product", "GFLOP/s", "sum/diff", "exact samples");
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        TypedJob job = { t, 0, in[t][0], in[t][1], out[t][0], NULL, ld[t], ldc[t], n, 0 };
+        double start = nowSeconds();
+        double product, sumdiff = 0.0;
+        int matches = 0;
+
+        poolParallelFor(pool, computeTyped, &job, n);
+        product = nowSeconds() - start;
+        if (job.failed) {
+            printf("Error: out of memory in the %s product\n", typeNames[t]);
+            status = 1;
+            continue;
+        }
+        for (int s = 0; s < TYPED_SAMPLES; s++) {
+            int64_t want = exact[s];
+
+            if (t == TYPE_SATURATE) {
+                want = want > INT32_MAX ? INT32_MAX : want < INT32_MIN ? INT32_MIN : want;
+            }
+            matches += typedValue(t, out[t][0], (size_t)si[s] * ldc[t] + sj[s]) == (double)want;
+        }
+
+        // The widening and saturating kernels only change the product
+        if (t <= TYPE_F64) {
+            job.sumdiff = 1;
+            job.D = out[t][1];
+            start = nowSeconds();
+            poolParallelFor(pool, computeTyped, &job, n);
+            sumdiff = nowSeconds() - start;
+            for (int s = 0; s < TYPED_SAMPLES; s++) {
+                double a = typedValue(t, in[t][0], (size_t)si[s] * ld[t] + sj[s]);
+                double b = typedValue(t, in[t][1], (size_t)si[s] * ld[t] + sj[s]);
+
+                if (typedValue(t, out[t][0], (size_t)si[s] * ldc[t] + sj[s]) != a + b ||
+                    typedValue(t, out[t][1], (size_t)si[s] * ldc[t] + sj[s]) != a - b) {
+                    printf("Error: %s sum/difference is wrong\n", typeNames[t]);
+                    status = 1;
+                    break;
+                }
+            }
+            printf("%-16s %7.3f ms %10.3f %10.3f ms %9d/%d\n", typeNames[t], product * 1e3,
+                   2.0 * n * n * n / product * 1e-9, sumdiff * 1e3, matches, TYPED_SAMPLES);
+        } else {
+            printf("%-16s %7.3f ms %10.3f %13s %9d/%d\n", typeNames[t], product * 1e3,
+                   2.0 * n * n * n / product * 1e-9, "-", matches, TYPED_SAMPLES);
+        }
+
+        // Only int32 may wrap and float may round; the rest must be exact
+        if (t != TYPE_I32 && t != TYPE_F32 && matches != TYPED_SAMPLES) {
+            printf("Error: %s product is not exact\n", typeNames[t]);
+            status = 1;
+        }
+        fflush(stdout);
+    }
+    status |= typedFullRangeCheck();
+
+    for (int b = 0; b < nbuffers; b++) {
+        free(buffers[b]);
+    }
+    return status;
+}
+
+// Returns 1 if t is the transpose of a
+int isTranspose(const Matrix* a, const Matrix* t) {
+    if (a->rows != t->cols || a->cols != t->rows) {
+        return 0;
+    }
+    for(int i = 0; i < a->rows; i++) {
+        for(int j = 0; j < a->cols; j++) {
+            if (MAT(a, i, j) != MAT(t, j, i)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Multiplies, adds and subtracts count random n x n matrix pairs as one batch
+// and compares every result with the blocked kernel run one matrix at a time
+int batchRun(int count, int n) {
+    MatrixBatch *A = batchAlloc(count, n, n), *B = batchAlloc(count, n, n);
+    MatrixBatch *C = batchAlloc(count, n, n), *S = batchAlloc(count, n, n);
+    MatrixBatch *D = batchAlloc(count, n, n);
+    Matrix *a = matrixAlloc(n, n), *b = matrixAlloc(n, n);
+    Matrix *c = matrixAlloc(n, n), *got = matrixAlloc(n, n);
+    double one_by_one = 0.0, start;
+    int status = 0;
+
+    if (!A || !B || !C || !S || !D || !a || !b || !c || !got) {
+        printf("Error: cannot allocate a batch of %d %dx%d matrices\n", count, n, n);
+        return 1;
+    }
+
+    // Matrix number t is values t * n * n onwards of the A and B streams
+    for (int t = 0; t < count; t++) {
+        for (int i = 0; i < n; i++) {
+            uint64_t first = ((uint64_t)t * n + i) * n;
+
+            rngFillRow(&MAT(a, i, 0), n, rngStream(seed, STREAM_A), first, 1, 10);
+            rngFillRow(&MAT(b, i, 0), n, rngStream(seed, STREAM_B), first, 1, 10);
+        }
+        batchSet(A, t, a);
+        batchSet(B, t, b);
+    }
+
+    start = nowSeconds();
+    batchMultiply(pool, A, B, C);
+    double product_time = nowSeconds() - start;
+    start = nowSeconds();
+    batchSumDiff(pool, A, B, S, D);
+    double sumdiff_time = nowSeconds() - start;
+
+    for (int t = 0; t < count && status == 0; t++) {
+        batchGet(A, t, a);
+        batchGet(B, t, b);
+        start = nowSeconds();
+        matmulBlocked(a->data, a->ld, b->data, b->ld, c->data, c->ld, 0, n, n, n);
+        one_by_one += nowSeconds() - start;
+        batchGet(C, t, got);
+        status |= !matrixEqual(c, got);
+        batchGet(S, t, got);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                status |= MAT(got, i, j) != MAT(a, i, j) + MAT(b, i, j);
+                status |= BATCH_AT(D, t, i, j) != MAT(a, i, j) - MAT(b, i, j);
+            }
+        }
+        if (status) {
+            printf("Error: batched results differ for matrix %d\n", t);
+        }
+    }
+
+    double flops = 2.0 * count * n * n * n;
+    printf("Batch of %d %dx%d matrices, %d threads, seed %llu:\n", count, n, n, pool->nthreads,
+           (unsigned long long)seed);
+    printf("%-22s %10.3f ms  %8.3f GFLOP/s\n", "batched product", product_time * 1e3,
+           flops / product_time * 1e-9);
+    printf("%-22s %10.3f ms  %8.3f GFLOP/s\n", "one by one (blocked)", one_by_one * 1e3,
+           status ? 0.0 : flops / one_by_one * 1e-9);
+    printf("%-22s %10.3f ms\n", "batched sum/diff", sumdiff_time * 1e3);
+
+    batchFree(A);
+    batchFree(B);
+    batchFree(C);
+    batchFree(S);
+    batchFree(D);
+    matrixFree(a);
+    matrixFree(b);
+    matrixFree(c);
+    matrixFree(got);
+    return status;
+}
+
+// Prints one row of the sparse table
+void sparseRow(const char* name, double seconds, long nnz, int correct) {
+    printf("%-22s %10.3f ms", name, seconds * 1e3);
+    if (nnz >= 0) {
+        printf("  %10ld nonzeros", nnz);
+    } else {
+        printf("  %19s", "");
+    }
+    printf("  %s\n", correct ? "ok" : "WRONG");
+}
+
+// Builds two n x n matrices with the given percentage of nonzeros, runs every
+// CSR kernel on them and compares each result with the dense kernels
+int sparseRun(int n, double percent) {
+    SparseFillJob fill = { NULL, 0, (int)(percent / 100.0 * SPARSE_SCALE) };
+    CsrMatrix *a = NULL, *b = NULL, *product = NULL, *sum = NULL;
+    Matrix *expanded = matrixAlloc(n, n);
+    int *x = malloc((size_t)n * sizeof(int));
+    int *y = malloc((size_t)n * sizeof(int));
+    int status = 0, ok;
+    double start, t;
+
+    matA = matrixAlloc(n, n);
+    matB = matrixAlloc(n, n);
+    matSumResult = matrixAlloc(n, n);
+    matBlockedResult = matrixAlloc(n, n);
+    if (!matA || !matB || !matSumResult || !matBlockedResult || !expanded || !x || !y) {
+        printf("Error: cannot allocate %dx%d matrices\n", n, n);
+        return 1;
+    }
+    touchMatrix(matSumResult);
+    touchMatrix(matBlockedResult);
+    touchMatrix(expanded);
+    fill.matrix = matA;
+    fill.stream = rngStream(seed, STREAM_A);
+    poolParallelFor(pool, computeSparseFill, &fill, n);
+    fill.matrix = matB;
+    fill.stream = rngStream(seed, STREAM_B);
+    poolParallelFor(pool, computeSparseFill, &fill, n);
+    rngFillRow(x, n, rngStream(seed, STREAM_VECTOR), 0, 1, 10);
+
+    // Dense references
+    double dense_product = runThreads(computeProductBlocked, n);
+    double dense_sum = runThreads(computeSum, n);
+
+    start = nowSeconds();
+    a = csrFromDense(pool, matA);
+    b = csrFromDense(pool, matB);
+    t = nowSeconds() - start;
+    if (a == NULL || b == NULL) {
+        printf("Error: cannot allocate the CSR matrices\n");
+        return 1;
+    }
+    printf("Sparse %dx%d, %.3g%% nonzeros, %d threads, seed %llu\n", n, n, percent,
+           pool->nthreads, (unsigned long long)seed);
+    printf("A and B: %ld and %ld nonzeros, %.1f MiB as CSR, %.1f MiB dense\n", a->nnz, b->nnz,
+           (csrBytes(a) + csrBytes(b)) / 1048576.0, 2.0 * n * matA->ld * sizeof(int) / 1048576.0);
+    printf("%-22s %10.3f ms\n", "dense blocked A * B", dense_product * 1e3);
+    printf("%-22s %10.3f ms\n", "dense A + B", dense_sum * 1e3);
+    csrToDense(pool, a, expanded);
+    sparseRow("to CSR (A and B)", t, a->nnz + b->nnz, matrixEqual(expanded, matA));
+
+    start = nowSeconds();
+    csrMulVector(pool, a, x, y);
+    t = nowSeconds() - start;
+    ok = 1;
+    for (int i = 0; i < n && ok; i++) {
+        int dot = 0;
+
+        for (int j = 0; j < n; j++) {
+            dot += MAT(matA, i, j) * x[j];
+        }
+        ok = dot == y[i];
+    }
+    sparseRow("SpMV A * x", t, -1, ok);
+    status |= !ok;
+
+    start = nowSeconds();
+    csrMulDense(pool, a, matB, expanded);
+    t = nowSeconds() - start;
+    ok = matrixEqual(expanded, matBlockedResult);
+    sparseRow("SpMM A * B (B dense)", t, -1, ok);
+    status |= !ok;
+
+    start = nowSeconds();
+    product = csrMulCsr(pool, a, b);
+    t = nowSeconds() - start;
+    if (product == NULL) {
+        printf("Error: cannot allocate the sparse product\n");
+        return 1;
+    }
+    csrToDense(pool, product, expanded);
+    ok = matrixEqual(expanded, matBlockedResult);
+    sparseRow("SpGEMM A * B", t, product->nnz, ok);
+    status |= !ok;
+
+    start = nowSeconds();
+    sum = csrAdd(pool, a, b);
+    t = nowSeconds() - start;
+    if (sum == NULL) {
+        printf("Error: cannot allocate the sparse sum\n");
+        return 1;
+    }
+    csrToDense(pool, sum, expanded);
+    ok = matrixEqual(expanded, matSumResult);
+    sparseRow("add A + B", t, sum->nnz, ok);
+    status |= !ok;
+
+    csrFree(a);
+    csrFree(b);
+    csrFree(product);
+    csrFree(sum);
+    matrixFree(expanded);
+    matrixFree(matA);
+    matrixFree(matB);
+    matrixFree(matSumResult);
+    matrixFree(matBlockedResult);
+    free(x);
+    free(y);
+    return status;
+}
+
+// Prints one GFLOP/s cell of the sweep table, or "wrong" if the result differs
+void sweepCell(int n, double seconds, int correct) {
+    if (!correct) {
+        printf(" %9s", "wrong");
+    } else {
+        printf(" %9.3f", 2.0 * n * n * n / seconds * 1e-9);
+    }
+}
+
+// Times every product kernel on square sizes SWEEP_MIN, 2*SWEEP_MIN, ... max_n
+// to show where Strassen starts paying off on this machine
+int crossoverSweep(int max_n) {
+    int ncross = sizeof(sweepCrossovers) / sizeof(sweepCrossovers[0]);
+    int status = 0;
+
+    printf("GFLOP/s, %d threads\n%6s %9s %9s %9s", pool->nthreads, "n", "naive", "blocked", "recursive");
+    for (int c = 0; c < ncross; c++) {
+        printf("  strs%-4d", sweepCrossovers[c]);
+    }
+    printf("\n");
+
+    for (int n = SWEEP_MIN; n <= max_n; n *= 2) {
+        matA = matrixAlloc(n, n);
+        matB = matrixAlloc(n, n);
+        matProductResult = matrixAlloc(n, n);
+        matBlockedResult = matrixAlloc(n, n);
+        matRecursiveResult = matrixAlloc(n, n);
+        if (!matA || !matB || !matProductResult || !matBlockedResult || !matRecursiveResult) {
+            printf("Error: cannot allocate %dx%d matrices\n", n, n);
+            return 1;
+        }
+        touchMatrix(matProductResult);
+        touchMatrix(matBlockedResult);
+        touchMatrix(matRecursiveResult);
+        fillMatrix(matA, STREAM_A);
+        fillMatrix(matB, STREAM_B);
+
+        double blocked = runThreads(computeProductBlocked, n);
+        printf("%6d", n);
+        if (n <= SWEEP_NAIVE_MAX) {
+            double naive = runThreads(computeProduct, n);
+            sweepCell(n, naive, matrixEqual(matProductResult, matBlockedResult));
+        } else {
+            printf(" %9s", "-");
+        }
+        sweepCell(n, blocked, 1);
+        double t = runRecursive(0, 0);
+        sweepCell(n, t, matrixEqual(matRecursiveResult, matBlockedResult));
+        for (int c = 0; c < ncross; c++) {
+            t = runRecursive(1, sweepCrossovers[c]);
+            sweepCell(n, t, matrixEqual(matRecursiveResult, matBlockedResult));
+            status |= !matrixEqual(matRecursiveResult, matBlockedResult);
+        }
+        printf("\n");
+        fflush(stdout);
+
+        matrixFree(matA);
+        matrixFree(matB);
+        matrixFree(matProductResult);
+        matrixFree(matBlockedResult);
+        matrixFree(matRecursiveResult);
+    }
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    int m = DEFAULT_SIZE, k = DEFAULT_SIZE, n = DEFAULT_SIZE;
+    int overlap = 0;
+    int num_threads = poolDefaultThreads();
+    int sweep = 0;
+    int types = 0;
+    int sparse = 0;
+    int batch = 0;
+    int pin = 0;
+    const char *path_a = NULL, *path_b = NULL, *path_out = NULL;
+
+    seed = time(0);
+    while (argc > 1 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-o") == 0) {
+            overlap = 1;
+        } else if (strcmp(argv[1], "-c") == 0) {
+            sweep = 1;
+        } else if (strcmp(argv[1], "-T") == 0) {
+            types = 1;
+        } else if (strcmp(argv[1], "-S") == 0) {
+            sparse = 1;
+        } else if (strcmp(argv[1], "-B") == 0) {
+            batch = 1;
+        } else if (strcmp(argv[1], "-p") == 0) {
+            pin = 1;
+        } else if (strcmp(argv[1], "-q") == 0) {
+            print_mode = PRINT_NONE;
+        } else if (strcmp(argv[1], "-P") == 0) {
+            print_mode = PRINT_ALL;
+        } else if ((strcmp(argv[1], "-a") == 0 || strcmp(argv[1], "-b") == 0 ||
+                    strcmp(argv[1], "-w") == 0) && argc > 2) {
+            if (argv[1][1] == 'a') {
+                path_a = argv[2];
+            } else if (argv[1][1] == 'b') {
+                path_b = argv[2];
+            } else {
+                path_out = argv[2];
+            }
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "-r") == 0 && argc > 2) {
+            seed = strtoull(argv[2], NULL, 0);
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "-s") == 0 && argc > 2 && atoi(argv[2]) > 1) {
+            crossover = atoi(argv[2]);
+            argv++;
+            argc--;
+        } else if (strcmp(argv[1], "-t") == 0 && argc > 2 && atoi(argv[2]) > 0) {
+            num_threads = atoi(argv[2]);
+            argv++;
+            argc--;
+        } else {
+            printf(USAGE);
+            return 1;
+        }
+        argv++;
+        argc--;
+    }
+    if (sparse) {
+        double percent = argc == 3 ? atof(argv[2]) : SPARSE_DEFAULT_PERCENT;
+
+        pool = poolCreate(num_threads, pin);
+        if (pool == NULL || argc > 3 || (argc >= 2 && atoi(argv[1]) <= 0) ||
+            percent <= 0.0 || percent > 100.0) {
+            printf(USAGE);
+            return 1;
+        }
+        int status = sparseRun(argc >= 2 ? atoi(argv[1]) : SPARSE_DEFAULT_SIZE, percent);
+        poolDestroy(pool);
+        return status;
+    }
+    if (batch) {
+        pool = poolCreate(num_threads, pin);
+        if (pool == NULL || argc > 3 || (argc >= 2 && atoi(argv[1]) <= 0) ||
+            (argc == 3 && atoi(argv[2]) <= 0)) {
+            printf(USAGE);
+            return 1;
+        }
+        int status = batchRun(argc >= 2 ? atoi(argv[1]) : BATCH_DEFAULT_COUNT,
+                              argc == 3 ? atoi(argv[2]) : DEFAULT_SIZE);
+        poolDestroy(pool);
+        return status;
+    }
+    if (sweep || types) {
+        pool = poolCreate(num_threads, pin);
+        if (pool == NULL || argc > 2 || (argc == 2 && atoi(argv[1]) <= 0)) {
+            printf(USAGE);
+            return 1;
+        }
+        int status;
+        if (types) {
+            status = typeSweep(argc == 2 ? atoi(argv[1]) : TYPED_DEFAULT_SIZE);
+        } else {
+            status = crossoverSweep(argc == 2 ? atoi(argv[1]) : SWEEP_NAIVE_MAX);
+        }
+        poolDestroy(pool);
+        return status;
+    }
+    if (argc == 2) {
+        m = k = n = atoi(argv[1]);
+    } else if (argc == 4) {
+        m = atoi(argv[1]);
+        k = atoi(argv[2]);
+        n = atoi(argv[3]);
+    } else if (argc != 1) {
+        printf(USAGE);
+        return 1;
+    }
+
+    // Loaded operands fix their own dimensions; a random one is sized to fit
+    double load_time = nowSeconds();
+    if (path_a != NULL) {
+        matA = matrixLoad(path_a);
+        if (matA == NULL) {
+            printf("Error: cannot load a matrix from %s\n", path_a);
+            return 1;
+        }
+        m = matA->rows;
+        k = matA->cols;
+    }
+    if (path_b != NULL) {
+        matB = matrixLoad(path_b);
+        if (matB == NULL) {
+            printf("Error: cannot load a matrix from %s\n", path_b);
+            return 1;
+        }
+        if (path_a != NULL && matB->rows != k) {
+            printf("Error: A is %dx%d but B is %dx%d\n", m, k, matB->rows, matB->cols);
+            return 1;
+        }
+        k = matB->rows;
+        n = matB->cols;
+    }
+    load_time = nowSeconds() - load_time;
+    if (path_a == NULL) {
+        matA = matrixAlloc(m, k);
+    }
+    if (path_b == NULL) {
+        matB = matrixAlloc(k, n);
+    }
+    matProductResult = matrixAlloc(m, n);
+    matBlockedResult = matrixAlloc(m, n);
+    matRecursiveResult = matrixAlloc(m, n);
+    matTransposed = matrixAlloc(k, m);
+    if (matA == NULL || matB == NULL || matProductResult == NULL || matBlockedResult == NULL ||
+        matRecursiveResult == NULL || matTransposed == NULL) {
+        printf(USAGE);
+        return 1;
+    }
+    int elementwise = (m == k && k == n);
+    if (elementwise) {
+        matSumResult = matrixAlloc(m, n);
+        matDiffResult = matrixAlloc(m, n);
+        matSumFused = matrixAlloc(m, n);
+        matDiffFused = matrixAlloc(m, n);
+        if (!matSumResult || !matDiffResult || !matSumFused || !matDiffFused) {
+            printf(USAGE);
+            return 1;
+        }
+    }
+
+    pool = poolCreate(num_threads, pin);
+    if (pool == NULL) {
+        printf("Error: cannot start worker threads\n");
+        return 1;
+    }
+    // WorkerStats is cache-line aligned, which calloc does not guarantee
+    void *fused_stats = NULL, *blocked_stats = NULL;
+    size_t stats_size = pool->nthreads * sizeof(WorkerStats);
+    if (posix_memalign(&fused_stats, sizeof(WorkerStats), stats_size) != 0 ||
+        posix_memalign(&blocked_stats, sizeof(WorkerStats), stats_size) != 0) {
+        printf("Error: out of memory\n");
+        return 1;
+    }
+    memset(fused_stats, 0, stats_size);
+    memset(blocked_stats, 0, stats_size);
+
+    // Let the workers place every result matrix, so each row lives on the
+    // node of the worker that will process it; A and B are placed by the fill
+    touchMatrix(matSumResult);
+    touchMatrix(matDiffResult);
+    touchMatrix(matSumFused);
+    touchMatrix(matDiffFused);
+    touchMatrix(matProductResult);
+    touchMatrix(matBlockedResult);
+    touchMatrix(matRecursiveResult);
+    touchMatrix(matTransposed);
+
+    // Fill the operands that were not loaded with random values
+    double fill_time = nowSeconds();
+    if (path_a == NULL) {
+        fillMatrix(matA, STREAM_A);
+    }
+    if (path_b == NULL) {
+        fillMatrix(matB, STREAM_B);
+    }
+    fill_time = nowSeconds() - fill_time;
+    if (path_a == NULL || path_b == NULL) {
+        printf("Seed: %llu\n", (unsigned long long)seed);
+    }
     
     // Display the original matrices
-    printf("Matrix A:\n");
-    printMatrix(matA);
-    printf("Matrix B:\n");
-    printMatrix(matB);
+    printMatrix("Matrix A:", matA);
+    printMatrix("Matrix B:", matB);
     
-    // Create thread objects and determine the number of rows each thread will process
-    pthread_t threads[10];
-    int num_threads = 10;
-    int rows_per_thread = MAX / num_threads;
-    
-    // Spawn threads to compute matrix addition
-    for(int i = 0; i < num_threads; i++) {
-        ThreadArgs* args = malloc(sizeof(ThreadArgs));
-        args->thread_id = i;
-        args->start_row = i * rows_per_thread;
-        args->end_row = (i == num_threads - 1) ? MAX : (i + 1) * rows_per_thread;
-        pthread_create(&threads[i], NULL, computeSum, (void*)args);
+    // Hand matrix addition and subtraction to the workers, as two passes and fused
+    double elementwise_time = 0.0, fused_time = 0.0;
+    if (elementwise) {
+        elementwise_time = runThreads(computeSum, m);
+        elementwise_time += runThreads(computeDiff, m);
+        if (!overlap) {
+            poolResetStats(pool);
+            fused_time = runThreads(computeSumDiff, m);
+            memcpy(fused_stats, pool->stats, pool->nthreads * sizeof(WorkerStats));
+        }
     }
     
-    // Wait for all addition threads to complete
-    for(int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+    // Repeat the process for matrix multiplication, once per kernel
+    double naive_time = runThreads(computeProduct, m);
+    double blocked_time;
+    poolResetStats(pool);
+    if (overlap && elementwise) {
+        // Queue the memory-bound pass behind the compute-bound product so
+        // the workers interleave them
+        double start = nowSeconds();
+        poolSplit(pool, computeProductBlocked, NULL, m);
+        poolSplit(pool, computeSumDiff, NULL, m);
+        poolWait(pool);
+        blocked_time = nowSeconds() - start;
+    } else {
+        blocked_time = runThreads(computeProductBlocked, m);
     }
+    memcpy(blocked_stats, pool->stats, pool->nthreads * sizeof(WorkerStats));
+    long blocked_steals = pool->steals;
+
+    // The divide-and-conquer kernels share one result matrix, so each is
+    // checked as soon as it finishes
+    double recursive_time = runRecursive(0, 0);
+    int recursive_ok = matrixEqual(matProductResult, matRecursiveResult);
+    double strassen_time = runRecursive(1, crossover);
+    int strassen_ok = matrixEqual(matProductResult, matRecursiveResult);
+
+    // Transpose A out of place, and the (checked) Strassen result in place
+    // when it is square
+    double transpose_time = nowSeconds();
+    matrixTranspose(pool, matA, matTransposed);
+    transpose_time = nowSeconds() - transpose_time;
+    int transpose_ok = isTranspose(matA, matTransposed);
+    double inplace_time = nowSeconds();
+    int inplace = matrixTransposeInPlace(pool, matRecursiveResult) == 0;
+    inplace_time = nowSeconds() - inplace_time;
+    transpose_ok = transpose_ok && (!inplace || isTranspose(matProductResult, matRecursiveResult));
     
-    // Repeat the process for matrix subtraction
-    for(int i = 0; i < num_threads; i++) {
-        ThreadArgs* args = malloc(sizeof(ThreadArgs));
-        args->thread_id = i;
-        args->start_row = i * rows_per_thread;
-        args->end_row = (i == num_threads - 1) ? MAX : (i + 1) * rows_per_thread;
-        pthread_create(&threads[i], NULL, computeDiff, (void*)args);
+    // Display the results of the operations
+    if (print_mode != PRINT_NONE) {
+        printf("Results:\n");
     }
-    
-    for(int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+    if (elementwise) {
+        printMatrix("Sum:", matSumResult);
+        printMatrix("Difference:", matDiffResult);
     }
-    
-    // Repeat the process for matrix multiplication
-    for(int i = 0; i < num_threads; i++) {
-        ThreadArgs* args = malloc(sizeof(ThreadArgs));
-        args->thread_id = i;
-        args->start_row = i * rows_per_thread;
-        args->end_row = (i == num_threads - 1) ? MAX : (i + 1) * rows_per_thread;
-        pthread_create(&threads[i], NULL, computeProduct, (void*)args);
+    printMatrix("Product:", matProductResult);
+
+    // Save the product
+    double store_time = nowSeconds();
+    int status = 0;
+    if (path_out != NULL) {
+        int rc = isTextPath(path_out) ? matrixStoreText(matProductResult, path_out)
+                                      : matrixStore(matProductResult, path_out);
+        if (rc != 0) {
+            printf("Error: cannot store the product in %s\n", path_out);
+            status = 1;
+        }
     }
-    
-    for(int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+    store_time = nowSeconds() - store_time;
+
+    printf("Product kernels (%dx%d * %dx%d, %d threads):\n", m, k, k, n, pool->nthreads);
+    reportProduct("naive i-j-k", naive_time);
+    reportProduct("blocked i-k-j", blocked_time);
+    reportProduct("recursive", recursive_time);
+    reportProduct("strassen", strassen_time);
+    if (path_a == NULL || path_b == NULL) {
+        printf("%-16s %10.3f ms\n", "random fill", fill_time * 1e3);
     }
-    
-    // Display the results of the operations
-    printf("Results:\n");
-    printf("Sum:\n");
-    printMatrix(matSumResult);
-    printf("Difference:\n");
-    printMatrix(matDiffResult);
-    printf("Product:\n");
-    printMatrix(matProductResult);
-    
-    return 0;
+    if (path_a != NULL || path_b != NULL) {
+        printf("%-16s %10.3f ms\n", "load", load_time * 1e3);
+    }
+    if (path_out != NULL) {
+        printf("%-16s %10.3f ms\n", "store product", store_time * 1e3);
+    }
+    printf("%-16s %10.3f ms\n", "transpose A", transpose_time * 1e3);
+    if (inplace) {
+        printf("%-16s %10.3f ms\n", "in-place C^T", inplace_time * 1e3);
+    }
+    if (elementwise) {
+        printf("%-16s %10.3f ms\n", "sum + difference", elementwise_time * 1e3);
+        if (overlap) {
+            printf("(blocked time includes the overlapped fused sum/difference)\n");
+        } else {
+            printf("%-16s %10.3f ms\n", "fused sum/diff", fused_time * 1e3);
+        }
+    }
+    if (elementwise && (!matrixEqual(matSumResult, matSumFused) ||
+                        !matrixEqual(matDiffResult, matDiffFused))) {
+        printf("Error: fused sum/difference does not match the separate passes\n");
+        status = 1;
+    }
+    if (elementwise && !overlap) {
+        reportWorkers("Fused sum/diff", fused_stats);
+    }
+    reportWorkers(overlap && elementwise ? "Blocked product + fused sum/diff" : "Blocked product",
+                  blocked_stats);
+    printf("Tiles stolen between workers: %ld\n", blocked_steals);
+    if (!matrixEqual(matProductResult, matBlockedResult)) {
+        printf("Error: blocked product does not match the naive product\n");
+        status = 1;
+    }
+    if (!recursive_ok || !strassen_ok) {
+        printf("Error: %s product does not match the naive product\n",
+               recursive_ok ? "strassen" : "recursive");
+        status = 1;
+    }
+    if (!transpose_ok) {
+        printf("Error: transpose is wrong\n");
+        status = 1;
+    }
+
+    poolDestroy(pool);
+    free(fused_stats);
+    free(blocked_stats);
+    matrixFree(matA);
+    matrixFree(matB);
+    matrixFree(matSumResult);
+    matrixFree(matDiffResult);
+    matrixFree(matSumFused);
+    matrixFree(matDiffFused);
+    matrixFree(matProductResult);
+    matrixFree(matBlockedResult);
+    matrixFree(matRecursiveResult);
+    matrixFree(matTransposed);
+    return status;
 }
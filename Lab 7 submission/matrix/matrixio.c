@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200112L
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrixio.h"
+
+// Bytes of formatted text collected before each write
+#define TEXT_BUFFER_SIZE (1 << 16)
+
+// Room for one formatted element: "-2147483648" and a separator
+#define TEXT_INT_CHARS 12
+
+// Column width of matrixWriteText, the old printf("%5d")
+#define TEXT_WIDTH 5
+
+// The header must fill exactly one aligned line so row 0 stays aligned
+typedef char matrixFileHeaderSize[sizeof(MatrixFileHeader) == MATRIX_ALIGN ? 1 : -1];
+
+// Maps a whole file copy-on-write; returns NULL if it is empty or unreadable
+static void *mapFile(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    void *map;
+
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    *size = st.st_size;
+    return map;
+}
+
+// Wraps a mapped binary file as a matrix once the header agrees with the file size
+static Matrix *loadBinary(void *map, size_t size) {
+    const MatrixFileHeader *h = map;
+    Matrix *m;
+
+    if (size < sizeof(MatrixFileHeader) || h->byte_order != MATRIX_FILE_BYTE_ORDER ||
+        h->elem_size != sizeof(int) || h->rows == 0 || h->cols == 0 ||
+        h->rows > INT_MAX || h->ld > INT_MAX || h->ld < h->cols ||
+        h->ld % MATRIX_LINE_INTS != 0 || h->data_offset < sizeof(MatrixFileHeader) ||
+        h->data_offset % MATRIX_ALIGN != 0 || h->data_offset > size ||
+        (size - h->data_offset) / (h->ld * sizeof(int)) < h->rows) {
+        return NULL;
+    }
+
+    m = malloc(sizeof(Matrix));
+    if (m == NULL) {
+        return NULL;
+    }
+    m->rows = (int)h->rows;
+    m->cols = (int)h->cols;
+    m->ld = (int)h->ld;
+    m->data = (int *)((char *)map + h->data_offset);
+    m->map = map;
+    m->map_size = size;
+    return m;
+}
+
+// Parses the next whitespace-separated int in [*pos, end) and advances *pos;
+// returns -1 on a malformed or out-of-range token, or when no token is left
+static int parseInt(const char **pos, const char *end, int *value) {
+    const char *p = *pos;
+    long long v = 0;
+    int negative = 0;
+
+    while (p < end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || !isdigit((unsigned char)*p)) {
+        return -1;
+    }
+    for (; p < end && isdigit((unsigned char)*p); p++) {
+        v = v * 10 + (*p - '0');
+        if (v > (long long)INT_MAX + 1) {
+            return -1;
+        }
+    }
+    if ((p < end && !isspace((unsigned char)*p)) || (!negative && v > INT_MAX)) {
+        return -1;
+    }
+    *value = negative ? (int)-v : (int)v;
+    *pos = p;
+    return 0;
+}
+
+// Parses a mapped text file into a newly allocated matrix
+static Matrix *loadText(const char *text, size_t size) {
+    const char *pos = text, *end = text + size;
+    int rows, cols;
+    Matrix *m;
+
+    if (parseInt(&pos, end, &rows) != 0 || parseInt(&pos, end, &cols) != 0) {
+        return NULL;
+    }
+    m = matrixAlloc(rows, cols);
+    if (m == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (parseInt(&pos, end, &MAT(m, i, j)) != 0) {
+                matrixFree(m);
+                return NULL;
+            }
+        }
+    }
+    while (pos < end && isspace((unsigned char)*pos)) {
+        pos++;
+    }
+    if (pos != end) {
+        matrixFree(m);
+        return NULL;
+    }
+    return m;
+}
+
+// Maps the file and either keeps the mapping (binary) or parses it (text)
+Matrix *matrixLoad(const char *path) {
+    size_t size;
+    void *map = mapFile(path, &size);
+    Matrix *m;
+
+    if (map == NULL) {
+        return NULL;
+    }
+    if (size >= sizeof(MatrixFileHeader) && memcmp(map, MATRIX_FILE_MAGIC, 8) == 0) {
+        m = loadBinary(map, size);
+        if (m == NULL) {
+            munmap(map, size);
+        }
+        return m;
+    }
+    m = loadText(map, size);
+    munmap(map, size);
+    return m;
+}
+
+// Sizes the file, maps it shared and copies the header and rows in
+int matrixStore(const Matrix *m, const char *path) {
+    MatrixFileHeader h;
+    size_t size = sizeof(MatrixFileHeader) + (size_t)m->rows * m->ld * sizeof(int);
+    int fd, saved;
+    char *map;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MATRIX_FILE_MAGIC, 8);
+    h.byte_order = MATRIX_FILE_BYTE_ORDER;
+    h.elem_size = sizeof(int);
+    h.rows = m->rows;
+    h.cols = m->cols;
+    h.ld = m->ld;
+    h.data_offset = sizeof(MatrixFileHeader);
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, size) != 0) {
+        saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    saved = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = saved;
+        return -1;
+    }
+
+    // The padding is left as the zeros ftruncate filled the file with
+    memcpy(map, &h, sizeof(h));
+    for (int i = 0; i < m->rows; i++) {
+        memcpy(map + h.data_offset + (size_t)i * m->ld * sizeof(int), &MAT(m, i, 0),
+               m->cols * sizeof(int));
+    }
+    return munmap(map, size);
+}
+
+// Writes "rows cols" and the elements to a new text file
+int matrixStoreText(const Matrix *m, const char *path) {
+    FILE *out = fopen(path, "w");
+    int status;
+
+    if (out == NULL) {
+        return -1;
+    }
+    status = fprintf(out, "%d %d\n", m->rows, m->cols) < 0 ? -1 : matrixWriteText(m, out);
+    if (fclose(out) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+// Formats v right-aligned in width characters at out, widening the field
+// when needed so a space always separates it from the previous element;
+// returns the number of characters written
+static int formatInt(char *out, int v, int width) {
+    char digits[TEXT_INT_CHARS];
+    unsigned int u = v < 0 ? 0u - (unsigned int)v : (unsigned int)v;
+    int n = 0, len;
+
+    do {
+        digits[n++] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    if (v < 0) {
+        digits[n++] = '-';
+    }
+    len = n < width ? width : n + 1;
+    memset(out, ' ', len - n);
+    for (int i = 0; i < n; i++) {
+        out[len - 1 - i] = digits[i];
+    }
+    return len;
+}
+
+// Formats whole rows into one buffer and writes it whenever it fills up
+int matrixWriteText(const Matrix *m, FILE *out) {
+    char *buffer = malloc(TEXT_BUFFER_SIZE);
+    size_t used = 0;
+    int status = 0;
+
+    if (buffer == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < m->rows && status == 0; i++) {
+        for (int j = 0; j < m->cols; j++) {
+            if (used + TEXT_INT_CHARS + 1 > TEXT_BUFFER_SIZE) {
+                if (fwrite(buffer, 1, used, out) != used) {
+                    status = -1;
+                    break;
+                }
+                used = 0;
+            }
+            used += formatInt(buffer + used, MAT(m, i, j), TEXT_WIDTH);
+        }
+        buffer[used++] = '\n';
+    }
+    if (status == 0 && fwrite(buffer, 1, used, out) != used) {
+        status = -1;
+    }
+    free(buffer);
+    return status;
+}
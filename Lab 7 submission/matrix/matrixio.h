@@ -0,0 +1,55 @@
+#ifndef MATRIXIO_H
+#define MATRIXIO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "dense.h"
+
+/**
+ * Matrix files.
+ *
+ * The binary format is a MatrixFileHeader followed by the rows exactly as
+ * they sit in memory, padding included, in native byte order. The header
+ * fills one 64-byte line, so a mapped file already has the aligned,
+ * padded layout of dense.h and is used in place: loading only maps it
+ * (copy-on-write, so the file is never modified) and the pages are read
+ * on first use. Storing maps the new file and copies the rows in.
+ *
+ * The text format is "rows cols" followed by the elements in row-major
+ * order, separated by any whitespace. It is parsed straight from a
+ * mapping and written through a large buffer, without stdio formatting.
+ */
+
+#define MATRIX_FILE_MAGIC "MATRIX01"
+
+/* Written to detect files from a machine with the other byte order. */
+#define MATRIX_FILE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[8];              // MATRIX_FILE_MAGIC, not NUL-terminated
+    uint32_t byte_order;        // MATRIX_FILE_BYTE_ORDER
+    uint32_t elem_size;         // bytes per element, sizeof(int)
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t ld;                // elements between row starts, a whole number of lines
+    uint64_t data_offset;       // bytes from the start of the file to row 0
+    char reserved[16];
+} MatrixFileHeader;
+
+/* Loads a binary (detected by its magic) or text matrix file; returns NULL
+ * if the file cannot be read or is malformed. */
+Matrix *matrixLoad(const char *path);
+
+/* Stores m in the binary format; returns 0, or -1 with errno set. */
+int matrixStore(const Matrix *m, const char *path);
+
+/* Stores m in the text format; returns 0, or -1 with errno set. */
+int matrixStoreText(const Matrix *m, const char *path);
+
+/* Writes the elements as rows of width-5 columns, the layout printMatrix
+ * uses (wider values get one leading space so the text can be read back),
+ * formatting into a buffer instead of one printf per element.
+ * Returns 0, or -1 if writing fails. */
+int matrixWriteText(const Matrix *m, FILE *out);
+
+#endif				// MATRIXIO_H
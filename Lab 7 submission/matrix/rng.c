@@ -0,0 +1,25 @@
+#include "rng.h"
+
+// Derives an independent stream key from the seed and a stream number
+uint64_t rngStream(uint64_t seed, uint64_t id) {
+    return rngMix(rngMix(seed) + id * RNG_GOLDEN);
+}
+
+// Maps the top 32 bits of a mixed counter onto [lo, hi] with a multiply
+// instead of a modulo
+int rngInt(uint64_t stream, uint64_t counter, int lo, int hi) {
+    uint64_t span = (uint64_t)((int64_t)hi - lo + 1);
+
+    return (int)(lo + (int64_t)(((rngMix(stream + counter * RNG_GOLDEN) >> 32) * span) >> 32));
+}
+
+// Fills one row; the loop has no carried state, so it vectorizes
+void rngFillRow(int *row, int n, uint64_t stream, uint64_t first, int lo, int hi) {
+    uint64_t span = (uint64_t)((int64_t)hi - lo + 1);
+
+    for (int j = 0; j < n; j++) {
+        uint64_t x = rngMix(stream + (first + j) * RNG_GOLDEN);
+
+        row[j] = (int)(lo + (int64_t)(((x >> 32) * span) >> 32));
+    }
+}
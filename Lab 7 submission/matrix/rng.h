@@ -0,0 +1,35 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * Counter-based random numbers for filling matrices.
+ *
+ * Value number i of a stream is a pure function of (stream key, i): the
+ * splitmix64 output function applied to key + i * golden ratio. There is
+ * no generator state to share or hand off, so any thread can produce any
+ * slice of a matrix, and the result for a given seed is the same whatever
+ * the thread count or split. Matrix elements are numbered row-major by
+ * (i * cols + j), independent of the padding.
+ */
+
+#define RNG_GOLDEN 0x9e3779b97f4a7c15ULL
+
+/* The splitmix64 finalizer: every input bit affects every output bit. */
+static inline uint64_t rngMix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* Key of stream id under seed, so that A and B get unrelated values. */
+uint64_t rngStream(uint64_t seed, uint64_t id);
+
+/* Value number counter of a stream, uniform in [lo, hi]. */
+int rngInt(uint64_t stream, uint64_t counter, int lo, int hi);
+
+/* row[j] = rngInt(stream, first + j, lo, hi) for j in [0, n). */
+void rngFillRow(int *row, int n, uint64_t stream, uint64_t first, int lo, int hi);
+
+#endif				// RNG_H
@@ -0,0 +1,451 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sparse.h"
+
+// Rows short enough to sort by insertion rather than qsort
+#define CSR_INSERTION_SORT 32
+
+// Shared arguments of the row-range kernels; each kernel uses some of them
+typedef struct {
+    const CsrMatrix *a;
+    const CsrMatrix *b;
+    const Matrix *dense;
+    Matrix *out_dense;
+    const int *x;
+    int *y;
+    CsrMatrix *out;
+    int failed;         // set by a task that could not allocate its scratch space
+} CsrJob;
+
+// Allocates the header and row pointers of a rows x cols matrix, without entries
+static CsrMatrix *csrAllocRows(int rows, int cols) {
+    CsrMatrix *a;
+
+    if (rows <= 0 || cols <= 0) {
+        return NULL;
+    }
+    a = calloc(1, sizeof(CsrMatrix));
+    if (a == NULL) {
+        return NULL;
+    }
+    a->rows = rows;
+    a->cols = cols;
+    a->row_ptr = malloc(((size_t)rows + 1) * sizeof(long));
+    if (a->row_ptr == NULL) {
+        free(a);
+        return NULL;
+    }
+    a->row_ptr[0] = 0;
+    return a;
+}
+
+// Allocates room for a->nnz entries; returns -1 on failure
+static int csrAllocEntries(CsrMatrix *a) {
+    size_t n = a->nnz > 0 ? (size_t)a->nnz : 1;
+
+    a->col_idx = malloc(n * sizeof(int));
+    a->values = malloc(n * sizeof(int));
+    return a->col_idx != NULL && a->values != NULL ? 0 : -1;
+}
+
+// Allocates a matrix with room for nnz nonzeros
+CsrMatrix *csrAlloc(int rows, int cols, long nnz) {
+    CsrMatrix *a = csrAllocRows(rows, cols);
+
+    if (a == NULL) {
+        return NULL;
+    }
+    a->nnz = nnz;
+    if (csrAllocEntries(a) != 0) {
+        csrFree(a);
+        return NULL;
+    }
+    return a;
+}
+
+// Frees the arrays and the header
+void csrFree(CsrMatrix *a) {
+    if (a == NULL) {
+        return;
+    }
+    free(a->row_ptr);
+    free(a->col_idx);
+    free(a->values);
+    free(a);
+}
+
+// Counts the storage of the row pointers and entries
+size_t csrBytes(const CsrMatrix *a) {
+    return ((size_t)a->rows + 1) * sizeof(long) + (size_t)a->nnz * 2 * sizeof(int);
+}
+
+// Turns the per-row counts in row_ptr[1..rows] into offsets and allocates the entries
+static int csrPrefix(CsrMatrix *a) {
+    for (int i = 0; i < a->rows; i++) {
+        a->row_ptr[i + 1] += a->row_ptr[i];
+    }
+    a->nnz = a->row_ptr[a->rows];
+    return csrAllocEntries(a);
+}
+
+// Weight of rows [0, i): their nonzeros in a and b (if any), plus one per row
+// so that runs of empty rows still get spread out
+static long csrWeight(const long *ptr_a, const long *ptr_b, int i) {
+    return ptr_a[i] + (ptr_b != NULL ? ptr_b[i] : 0) + i;
+}
+
+// Cuts the rows into tiles of about equal weight (see csrWeight), runs fn on
+// them across the pool and waits. Falls back to an even row split if the
+// tile table cannot be allocated.
+static void csrParallelFor(ThreadPool *pool, RangeFn fn, void *arg, int rows,
+                           const long *ptr_a, const long *ptr_b) {
+    int tiles = pool->nthreads * POOL_TILES_PER_WORKER;
+    long total;
+    int *bounds;
+
+    if (tiles > rows) {
+        tiles = rows;
+    }
+    bounds = malloc(((size_t)tiles + 1) * sizeof(int));
+    if (bounds == NULL) {
+        poolParallelFor(pool, fn, arg, rows);
+        return;
+    }
+
+    total = csrWeight(ptr_a, ptr_b, rows);
+    bounds[0] = 0;
+    bounds[tiles] = rows;
+    for (int t = 1; t < tiles; t++) {
+        long target = total * t / tiles;
+        int lo = bounds[t - 1], hi = rows;
+
+        // First row boundary whose prefix weight reaches the target
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+
+            if (csrWeight(ptr_a, ptr_b, mid) < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bounds[t] = lo;
+    }
+    poolSplitRanges(pool, fn, arg, bounds, tiles);
+    poolWait(pool);
+    free(bounds);
+}
+
+// qsort comparison of two ints
+static int compareInts(const void *x, const void *y) {
+    int a = *(const int *)x, b = *(const int *)y;
+
+    return (a > b) - (a < b);
+}
+
+// Sorts the column indices of one output row
+static void sortColumns(int *cols, int n) {
+    if (n > CSR_INSERTION_SORT) {
+        qsort(cols, n, sizeof(int), compareInts);
+        return;
+    }
+    for (int i = 1; i < n; i++) {
+        int c = cols[i], j = i;
+
+        for (; j > 0 && cols[j - 1] > c; j--) {
+            cols[j] = cols[j - 1];
+        }
+        cols[j] = c;
+    }
+}
+
+// Counts the nonzeros of the assigned dense rows
+static void countDenseRows(void *arg, int start, int end) {
+    CsrJob *job = arg;
+
+    for (int i = start; i < end; i++) {
+        long count = 0;
+
+        for (int j = 0; j < job->dense->cols; j++) {
+            count += MAT(job->dense, i, j) != 0;
+        }
+        job->out->row_ptr[i + 1] = count;
+    }
+}
+
+// Copies the nonzeros of the assigned dense rows to their offsets
+static void fillDenseRows(void *arg, int start, int end) {
+    CsrJob *job = arg;
+
+    for (int i = start; i < end; i++) {
+        long p = job->out->row_ptr[i];
+
+        for (int j = 0; j < job->dense->cols; j++) {
+            int v = MAT(job->dense, i, j);
+
+            if (v != 0) {
+                job->out->col_idx[p] = j;
+                job->out->values[p] = v;
+                p++;
+            }
+        }
+    }
+}
+
+// Every dense row costs the same to scan, so the count and fill use plain row splits
+CsrMatrix *csrFromDense(ThreadPool *pool, const Matrix *m) {
+    CsrJob job = { 0 };
+
+    job.dense = m;
+    job.out = csrAllocRows(m->rows, m->cols);
+    if (job.out == NULL) {
+        return NULL;
+    }
+    poolParallelFor(pool, countDenseRows, &job, m->rows);
+    if (csrPrefix(job.out) != 0) {
+        csrFree(job.out);
+        return NULL;
+    }
+    poolParallelFor(pool, fillDenseRows, &job, m->rows);
+    return job.out;
+}
+
+// Clears the assigned dense rows and scatters the nonzeros into them
+static void expandRows(void *arg, int start, int end) {
+    CsrJob *job = arg;
+    const CsrMatrix *a = job->a;
+
+    for (int i = start; i < end; i++) {
+        int *row = &MAT(job->out_dense, i, 0);
+
+        memset(row, 0, a->cols * sizeof(int));
+        for (long p = a->row_ptr[i]; p < a->row_ptr[i + 1]; p++) {
+            row[a->col_idx[p]] = a->values[p];
+        }
+    }
+}
+
+void csrToDense(ThreadPool *pool, const CsrMatrix *a, Matrix *m) {
+    CsrJob job = { 0 };
+
+    job.a = a;
+    job.out_dense = m;
+    csrParallelFor(pool, expandRows, &job, a->rows, a->row_ptr, NULL);
+}
+
+// Dot product of each assigned row with x
+static void spmvRows(void *arg, int start, int end) {
+    CsrJob *job = arg;
+    const CsrMatrix *a = job->a;
+
+    for (int i = start; i < end; i++) {
+        int sum = 0;
+
+        for (long p = a->row_ptr[i]; p < a->row_ptr[i + 1]; p++) {
+            sum += a->values[p] * job->x[a->col_idx[p]];
+        }
+        job->y[i] = sum;
+    }
+}
+
+void csrMulVector(ThreadPool *pool, const CsrMatrix *a, const int *x, int *y) {
+    CsrJob job = { 0 };
+
+    job.a = a;
+    job.x = x;
+    job.y = y;
+    csrParallelFor(pool, spmvRows, &job, a->rows, a->row_ptr, NULL);
+}
+
+// Row i of C is the sum of the rows of B picked out by row i of a, each
+// scaled by its value; the inner loop is a unit-stride axpy
+static void spmmRows(void *arg, int start, int end) {
+    CsrJob *job = arg;
+    const CsrMatrix *a = job->a;
+    int n = job->dense->cols;
+
+    for (int i = start; i < end; i++) {
+        int *restrict c = &MAT(job->out_dense, i, 0);
+
+        memset(c, 0, n * sizeof(int));
+        for (long p = a->row_ptr[i]; p < a->row_ptr[i + 1]; p++) {
+            const int *restrict b = &MAT(job->dense, a->col_idx[p], 0);
+            int v = a->values[p];
+
+            for (int j = 0; j < n; j++) {
+                c[j] += v * b[j];
+            }
+        }
+    }
+}
+
+void csrMulDense(ThreadPool *pool, const CsrMatrix *a, const Matrix *B, Matrix *C) {
+    CsrJob job = { 0 };
+
+    job.a = a;
+    job.dense = B;
+    job.out_dense = C;
+    csrParallelFor(pool, spmmRows, &job, a->rows, a->row_ptr, NULL);
+}
+
+// SpGEMM passes over the assigned rows. The symbolic pass (values == 0)
+// counts the distinct columns of each output row; the numeric pass sums
+// into a dense accumulator, then sorts and stores the touched columns.
+// mark[c] == i records that column c was touched in row i.
+static void spgemmRows(void *arg, int start, int end, int numeric) {
+    CsrJob *job = arg;
+    const CsrMatrix *a = job->a, *b = job->b;
+    CsrMatrix *c = job->out;
+    int *mark = malloc((size_t)b->cols * sizeof(int));
+    int *acc = numeric ? malloc((size_t)b->cols * sizeof(int)) : NULL;
+    int *touched = numeric ? malloc((size_t)b->cols * sizeof(int)) : NULL;
+
+    if (mark == NULL || (numeric && (acc == NULL || touched == NULL))) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        free(mark);
+        free(acc);
+        free(touched);
+        return;
+    }
+    for (int j = 0; j < b->cols; j++) {
+        mark[j] = -1;
+    }
+
+    for (int i = start; i < end; i++) {
+        int count = 0;
+
+        for (long p = a->row_ptr[i]; p < a->row_ptr[i + 1]; p++) {
+            int row = a->col_idx[p], v = a->values[p];
+
+            for (long q = b->row_ptr[row]; q < b->row_ptr[row + 1]; q++) {
+                int col = b->col_idx[q];
+
+                if (mark[col] != i) {
+                    mark[col] = i;
+                    if (numeric) {
+                        acc[col] = 0;
+                        touched[count] = col;
+                    }
+                    count++;
+                }
+                if (numeric) {
+                    acc[col] += v * b->values[q];
+                }
+            }
+        }
+
+        if (!numeric) {
+            c->row_ptr[i + 1] = count;
+            continue;
+        }
+        sortColumns(touched, count);
+        for (int t = 0; t < count; t++) {
+            c->col_idx[c->row_ptr[i] + t] = touched[t];
+            c->values[c->row_ptr[i] + t] = acc[touched[t]];
+        }
+    }
+    free(mark);
+    free(acc);
+    free(touched);
+}
+
+static void spgemmCount(void *arg, int start, int end) {
+    spgemmRows(arg, start, end, 0);
+}
+
+static void spgemmFill(void *arg, int start, int end) {
+    spgemmRows(arg, start, end, 1);
+}
+
+CsrMatrix *csrMulCsr(ThreadPool *pool, const CsrMatrix *a, const CsrMatrix *b) {
+    CsrJob job = { 0 };
+
+    if (a->cols != b->rows) {
+        return NULL;
+    }
+    job.a = a;
+    job.b = b;
+    job.out = csrAllocRows(a->rows, b->cols);
+    if (job.out == NULL) {
+        return NULL;
+    }
+    csrParallelFor(pool, spgemmCount, &job, a->rows, a->row_ptr, NULL);
+    if (job.failed || csrPrefix(job.out) != 0) {
+        csrFree(job.out);
+        return NULL;
+    }
+    csrParallelFor(pool, spgemmFill, &job, a->rows, a->row_ptr, NULL);
+    if (job.failed) {
+        csrFree(job.out);
+        return NULL;
+    }
+    return job.out;
+}
+
+// Merges the sorted rows of a and b. Without entries allocated (numeric == 0)
+// it only counts the union of the columns of each row.
+static void addRows(void *arg, int start, int end, int numeric) {
+    CsrJob *job = arg;
+    const CsrMatrix *a = job->a, *b = job->b;
+    CsrMatrix *c = job->out;
+
+    for (int i = start; i < end; i++) {
+        long p = a->row_ptr[i], pend = a->row_ptr[i + 1];
+        long q = b->row_ptr[i], qend = b->row_ptr[i + 1];
+        long out = numeric ? c->row_ptr[i] : 0;
+
+        while (p < pend || q < qend) {
+            int col;
+            int v;
+
+            if (q == qend || (p < pend && a->col_idx[p] < b->col_idx[q])) {
+                col = a->col_idx[p];
+                v = a->values[p++];
+            } else if (p == pend || b->col_idx[q] < a->col_idx[p]) {
+                col = b->col_idx[q];
+                v = b->values[q++];
+            } else {
+                col = a->col_idx[p];
+                v = a->values[p++] + b->values[q++];
+            }
+            if (numeric) {
+                c->col_idx[out] = col;
+                c->values[out] = v;
+            }
+            out++;
+        }
+        if (!numeric) {
+            c->row_ptr[i + 1] = out;
+        }
+    }
+}
+
+static void addCount(void *arg, int start, int end) {
+    addRows(arg, start, end, 0);
+}
+
+static void addFill(void *arg, int start, int end) {
+    addRows(arg, start, end, 1);
+}
+
+// Balanced on the nonzeros of both operands, which is the merge work
+CsrMatrix *csrAdd(ThreadPool *pool, const CsrMatrix *a, const CsrMatrix *b) {
+    CsrJob job = { 0 };
+
+    if (a->rows != b->rows || a->cols != b->cols) {
+        return NULL;
+    }
+    job.a = a;
+    job.b = b;
+    job.out = csrAllocRows(a->rows, a->cols);
+    if (job.out == NULL) {
+        return NULL;
+    }
+    csrParallelFor(pool, addCount, &job, a->rows, a->row_ptr, b->row_ptr);
+    if (csrPrefix(job.out) != 0) {
+        csrFree(job.out);
+        return NULL;
+    }
+    csrParallelFor(pool, addFill, &job, a->rows, a->row_ptr, b->row_ptr);
+    return job.out;
+}
@@ -0,0 +1,60 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "dense.h"
+#include "threadpool.h"
+
+/**
+ * Compressed sparse row (CSR) matrices.
+ *
+ * Row i holds the nonzeros row_ptr[i] .. row_ptr[i + 1] - 1 of col_idx and
+ * values, with the columns in increasing order. Every kernel runs on the
+ * worker pool, and rows are split into tiles of roughly equal nonzero
+ * count rather than equal row count, so a few dense rows cannot leave one
+ * worker with most of the work.
+ *
+ * Kernels that produce a CSR matrix make two passes over the rows: the
+ * first counts each output row, a prefix sum turns the counts into
+ * row_ptr, and the second fills the rows in parallel at their final
+ * offsets. Arithmetic is int and wraps like the dense kernels.
+ */
+
+typedef struct {
+    int rows;
+    int cols;
+    long nnz;
+    long *row_ptr;      // rows + 1 entries
+    int *col_idx;       // nnz entries
+    int *values;        // nnz entries
+} CsrMatrix;
+
+/* Allocates a rows x cols matrix with room for nnz nonzeros; only row_ptr[0]
+ * is set. Returns NULL on failure. */
+CsrMatrix *csrAlloc(int rows, int cols, long nnz);
+
+void csrFree(CsrMatrix *a);
+
+/* Bytes used by the three arrays. */
+size_t csrBytes(const CsrMatrix *a);
+
+/* Compresses the nonzeros of a dense matrix. */
+CsrMatrix *csrFromDense(ThreadPool *pool, const Matrix *m);
+
+/* Expands a into the dense matrix m of the same shape. */
+void csrToDense(ThreadPool *pool, const CsrMatrix *a, Matrix *m);
+
+/* y = a * x (SpMV); x has a->cols entries and y a->rows. */
+void csrMulVector(ThreadPool *pool, const CsrMatrix *a, const int *x, int *y);
+
+/* C = a * B with B and C dense (SpMM); B is a->cols x n, C a->rows x n. */
+void csrMulDense(ThreadPool *pool, const CsrMatrix *a, const Matrix *B, Matrix *C);
+
+/* Returns a * b (SpGEMM, row by row with a dense accumulator), or NULL.
+ * Entries that cancel to zero are kept as explicit zeros. */
+CsrMatrix *csrMulCsr(ThreadPool *pool, const CsrMatrix *a, const CsrMatrix *b);
+
+/* Returns a + b, or NULL if the shapes differ or memory runs out; like
+ * csrMulCsr it keeps entries that cancel to zero. */
+CsrMatrix *csrAdd(ThreadPool *pool, const CsrMatrix *a, const CsrMatrix *b);
+
+#endif				// SPARSE_H
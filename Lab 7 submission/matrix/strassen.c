@@ -0,0 +1,254 @@
+#include <stddef.h>
+#include "dense.h"
+#include "matmul.h"
+#include "strassen.h"
+
+// One recursive subproblem, C (+)= A * B
+typedef struct {
+    ThreadPool *pool;
+    const int *A;
+    int lda;
+    const int *B;
+    int ldb;
+    int *C;
+    int ldc;
+    int m, n, k;
+    int add;            // accumulate into C instead of overwriting it
+} RecJob;
+
+// The seven products of one Strassen level
+typedef struct {
+    ThreadPool *pool;
+    const int *A;
+    int lda;
+    const int *B;
+    int ldb;
+    int mh, nh, kh;     // quadrant sizes
+    int crossover;
+    Matrix *M[7];       // the products
+    Matrix *S[7];       // left operand sums, NULL where a quadrant is used as is
+    Matrix *T[7];       // right operand sums, likewise
+} StrassenLevel;
+
+static void recurse(const RecJob *job);
+static void strassen(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                     int *C, int ldc, int m, int n, int k, int crossover);
+
+// Pool entry point for one half of a split
+static void recurseTask(void *arg, int start, int end) {
+    recurse(arg);
+}
+
+// Halves the largest dimension until the problem fits the blocked kernel
+static void recurse(const RecJob *job) {
+    RecJob lo = *job, hi = *job;
+    TaskGroup group = { 0 };
+    long work = (long)job->m * job->n * job->k;
+
+    if (job->m <= RECURSIVE_LEAF && job->n <= RECURSIVE_LEAF && job->k <= RECURSIVE_LEAF) {
+        if (job->add) {
+            matmulBlockedAdd(job->A, job->lda, job->B, job->ldb, job->C, job->ldc,
+                             0, job->m, job->n, job->k);
+        } else {
+            matmulBlocked(job->A, job->lda, job->B, job->ldb, job->C, job->ldc,
+                          0, job->m, job->n, job->k);
+        }
+        return;
+    }
+
+    if (job->k >= job->m && job->k >= job->n) {
+        // Both halves update the same C, so they run one after the other
+        lo.k = job->k / 2;
+        hi.k = job->k - lo.k;
+        hi.A += lo.k;
+        hi.B += (size_t)lo.k * job->ldb;
+        hi.add = 1;
+        recurse(&lo);
+        recurse(&hi);
+        return;
+    }
+
+    if (job->m >= job->n) {
+        lo.m = job->m / 2;
+        hi.m = job->m - lo.m;
+        hi.A += (size_t)lo.m * job->lda;
+        hi.C += (size_t)lo.m * job->ldc;
+    } else {
+        lo.n = job->n / 2;
+        hi.n = job->n - lo.n;
+        hi.B += lo.n;
+        hi.C += lo.n;
+    }
+
+    if (job->pool != NULL && work >= RECURSIVE_TASK_WORK) {
+        poolGroupSubmit(job->pool, &group, recurseTask, &hi, 0, 1);
+        recurse(&lo);
+        poolGroupWait(job->pool, &group);
+    } else {
+        recurse(&lo);
+        recurse(&hi);
+    }
+}
+
+// Computes C = A * B by cache-oblivious recursion
+void matmulRecursive(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                     int *C, int ldc, int m, int n, int k) {
+    RecJob job = { pool, A, lda, B, ldb, C, ldc, m, n, k, 0 };
+
+    recurse(&job);
+}
+
+// Operands of the seven products as {quadrant, quadrant, sign}: the operand is
+// q1 + sign * q2, or just q1 when sign is 0. Quadrants are 0 = 11, 1 = 12,
+// 2 = 21, 3 = 22.
+static const signed char strassenLeft[7][3] = {
+    { 0, 3, 1 }, { 2, 3, 1 }, { 0, 0, 0 }, { 3, 0, 0 }, { 0, 1, 1 }, { 2, 0, -1 }, { 1, 3, -1 }
+};
+static const signed char strassenRight[7][3] = {
+    { 0, 3, 1 }, { 0, 0, 0 }, { 1, 3, -1 }, { 2, 0, -1 }, { 3, 0, 0 }, { 0, 1, 1 }, { 2, 3, 1 }
+};
+
+// Returns quadrant q of a matrix split into rh x ch quadrants
+static const int *quadrant(const int *X, int ld, int rh, int ch, int q) {
+    return X + (size_t)(q >> 1) * rh * ld + (q & 1) * ch;
+}
+
+// Forms one Strassen operand: a quadrant as is, or the sum/difference of two
+// quadrants written into the preallocated temporary Tmp
+static const int *strassenOperand(const int *X, int ld, int rows, int cols,
+                                  const signed char op[3], Matrix *Tmp, int *out_ld) {
+    const int *p = quadrant(X, ld, rows, cols, op[0]);
+    const int *q = quadrant(X, ld, rows, cols, op[1]);
+
+    if (op[2] == 0) {
+        *out_ld = ld;
+        return p;
+    }
+    for (int i = 0; i < rows; i++) {
+        const int *pi = p + (size_t)i * ld;
+        const int *qi = q + (size_t)i * ld;
+        int *t = &MAT(Tmp, i, 0);
+
+        if (op[2] > 0) {
+            for (int j = 0; j < cols; j++) {
+                t[j] = pi[j] + qi[j];
+            }
+        } else {
+            for (int j = 0; j < cols; j++) {
+                t[j] = pi[j] - qi[j];
+            }
+        }
+    }
+    *out_ld = Tmp->ld;
+    return Tmp->data;
+}
+
+// Computes product number start of a Strassen level into level->M[start]
+static void strassenProduct(void *arg, int start, int end) {
+    StrassenLevel *level = arg;
+    int lds, ldt;
+    const int *S = strassenOperand(level->A, level->lda, level->mh, level->kh,
+                                   strassenLeft[start], level->S[start], &lds);
+    const int *T = strassenOperand(level->B, level->ldb, level->kh, level->nh,
+                                   strassenRight[start], level->T[start], &ldt);
+    Matrix *M = level->M[start];
+
+    strassen(level->pool, S, lds, T, ldt, M->data, M->ld, level->mh, level->nh, level->kh,
+             level->crossover);
+}
+
+// Frees whatever temporaries of a level were allocated
+static void strassenFreeLevel(StrassenLevel *level) {
+    for (int i = 0; i < 7; i++) {
+        matrixFree(level->M[i]);
+        matrixFree(level->S[i]);
+        matrixFree(level->T[i]);
+    }
+}
+
+// Allocates the seven products and the operand temporaries; returns 0 on success
+static int strassenAllocLevel(StrassenLevel *level) {
+    int ok = 1;
+
+    for (int i = 0; i < 7; i++) {
+        level->M[i] = matrixAlloc(level->mh, level->nh);
+        level->S[i] = strassenLeft[i][2] ? matrixAlloc(level->mh, level->kh) : NULL;
+        level->T[i] = strassenRight[i][2] ? matrixAlloc(level->kh, level->nh) : NULL;
+        ok = ok && level->M[i] != NULL && (!strassenLeft[i][2] || level->S[i] != NULL) &&
+             (!strassenRight[i][2] || level->T[i] != NULL);
+    }
+    if (!ok) {
+        strassenFreeLevel(level);
+        return -1;
+    }
+    return 0;
+}
+
+// C = A * B: one Strassen level on the even part, thin products for odd edges
+static void strassen(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                     int *C, int ldc, int m, int n, int k, int crossover) {
+    StrassenLevel level = { pool, A, lda, B, ldb, m / 2, n / 2, k / 2, crossover,
+                            { NULL }, { NULL }, { NULL } };
+    TaskGroup group = { 0 };
+    int m2 = m & ~1, n2 = n & ~1, k2 = k & ~1;
+    int mh = level.mh, nh = level.nh;
+
+    if (m < crossover || n < crossover || k < crossover || strassenAllocLevel(&level) != 0) {
+        matmulRecursive(pool, A, lda, B, ldb, C, ldc, m, n, k);
+        return;
+    }
+
+    if (pool != NULL && (long)mh * nh * level.kh >= RECURSIVE_TASK_WORK) {
+        for (int i = 1; i < 7; i++) {
+            poolGroupSubmit(pool, &group, strassenProduct, &level, i, i + 1);
+        }
+        strassenProduct(&level, 0, 1);
+        poolGroupWait(pool, &group);
+    } else {
+        for (int i = 0; i < 7; i++) {
+            strassenProduct(&level, i, i + 1);
+        }
+    }
+
+    // C11 = M1 + M4 - M5 + M7, C12 = M3 + M5, C21 = M2 + M4, C22 = M1 - M2 + M3 + M6
+    for (int i = 0; i < mh; i++) {
+        int *c11 = C + (size_t)i * ldc;
+        int *c12 = c11 + nh;
+        int *c21 = C + (size_t)(i + mh) * ldc;
+        int *c22 = c21 + nh;
+        const int *m1 = &MAT(level.M[0], i, 0), *m2 = &MAT(level.M[1], i, 0);
+        const int *m3 = &MAT(level.M[2], i, 0), *m4 = &MAT(level.M[3], i, 0);
+        const int *m5 = &MAT(level.M[4], i, 0), *m6 = &MAT(level.M[5], i, 0);
+        const int *m7 = &MAT(level.M[6], i, 0);
+
+        for (int j = 0; j < nh; j++) {
+            c11[j] = m1[j] + m4[j] - m5[j] + m7[j];
+            c12[j] = m3[j] + m5[j];
+            c21[j] = m2[j] + m4[j];
+            c22[j] = m1[j] - m2[j] + m3[j] + m6[j];
+        }
+    }
+    strassenFreeLevel(&level);
+
+    // Odd k: the last inner index adds a rank-1 update to the even block
+    if (k2 < k) {
+        matmulBlockedAdd(A + k2, lda, B + (size_t)k2 * ldb, ldb, C, ldc, 0, m2, n2, 1);
+    }
+    // Odd n: the last column of C in full
+    if (n2 < n) {
+        matmulBlocked(A, lda, B + n2, ldb, C + n2, ldc, 0, m, 1, k);
+    }
+    // Odd m: the last row of C, except the corner done with the column
+    if (m2 < m) {
+        matmulBlocked(A + (size_t)m2 * lda, lda, B, ldb, C + (size_t)m2 * ldc, ldc, 0, 1, n2, k);
+    }
+}
+
+// Computes C = A * B with Strassen steps above the crossover size
+void matmulStrassen(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                    int *C, int ldc, int m, int n, int k, int crossover) {
+    if (crossover < 2) {
+        crossover = 2;
+    }
+    strassen(pool, A, lda, B, ldb, C, ldc, m, n, k, crossover);
+}
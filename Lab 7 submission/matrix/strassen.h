@@ -0,0 +1,42 @@
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include "threadpool.h"
+
+/**
+ * Divide-and-conquer matrix multiply.
+ *
+ * matmulRecursive is cache oblivious: it halves the largest of m, n and k
+ * until the problem fits the blocked kernel, so every level of the cache
+ * hierarchy sees a working set that fits it without tuning a tile size per
+ * level. Halves of m or n are independent and run as pool tasks.
+ *
+ * matmulStrassen trades one of the eight half-size products for extra
+ * additions (seven products instead of eight) at each level while all
+ * three dimensions are at least the crossover size, then hands over to
+ * matmulRecursive. Odd dimensions are handled by peeling off the last
+ * row/column/inner index and fixing them up with thin products. The seven
+ * products of a level run as parallel tasks.
+ *
+ * Both compute C = A * B (A is m x k, B is k x n) with the leading
+ * dimension conventions of matmul.h. Integer arithmetic wraps the same way
+ * as the direct kernels, so results match them exactly.
+ */
+
+/* Default size below which Strassen hands over to the recursive multiply. */
+#define STRASSEN_CROSSOVER 256
+
+/* The recursive multiply stops splitting once every dimension is at most
+ * this, and calls the blocked kernel. */
+#define RECURSIVE_LEAF 128
+
+/* Subproblems with fewer multiply-adds than this run inline, not as tasks. */
+#define RECURSIVE_TASK_WORK (1L << 21)
+
+void matmulRecursive(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                     int *C, int ldc, int m, int n, int k);
+
+void matmulStrassen(ThreadPool *pool, const int *A, int lda, const int *B, int ldb,
+                    int *C, int ldc, int m, int n, int k, int crossover);
+
+#endif				// STRASSEN_H
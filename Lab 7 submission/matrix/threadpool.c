@@ -0,0 +1,443 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+// The pool and deque index of the calling thread, when it is a worker
+static __thread ThreadPool *current_pool = NULL;
+static __thread int current_worker = -1;
+
+// Startup record handed to each worker thread
+typedef struct {
+    ThreadPool *pool;
+    int index;
+} WorkerStart;
+
+// Sets up an empty deque
+static int dequeInit(Deque *d) {
+    d->ring = malloc(DEQUE_INITIAL_CAPACITY * sizeof(Task));
+    if (d->ring == NULL) {
+        return -1;
+    }
+    d->capacity = DEQUE_INITIAL_CAPACITY;
+    d->top = 0;
+    d->count = 0;
+    pthread_mutex_init(&d->lock, NULL);
+    return 0;
+}
+
+// Doubles the deque ring, unwrapping it into the new buffer; called with the lock held
+static int dequeGrow(Deque *d) {
+    Task *ring = malloc(2 * d->capacity * sizeof(Task));
+
+    if (ring == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < d->count; i++) {
+        ring[i] = d->ring[(d->top + i) & (d->capacity - 1)];
+    }
+    free(d->ring);
+    d->ring = ring;
+    d->capacity *= 2;
+    d->top = 0;
+    return 0;
+}
+
+// Pushes a task on the bottom; returns -1 if the ring cannot grow
+static int dequePush(Deque *d, const Task *task) {
+    pthread_mutex_lock(&d->lock);
+    if (d->count == d->capacity && dequeGrow(d) != 0) {
+        pthread_mutex_unlock(&d->lock);
+        return -1;
+    }
+    d->ring[(d->top + d->count) & (d->capacity - 1)] = *task;
+    d->count++;
+    pthread_mutex_unlock(&d->lock);
+    return 0;
+}
+
+// Owner side: takes the newest task from the bottom
+static int dequePop(Deque *d, Task *task) {
+    int found = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        d->count--;
+        *task = d->ring[(d->top + d->count) & (d->capacity - 1)];
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// Thief side: takes the oldest task from the top
+static int dequeSteal(Deque *d, Task *task) {
+    int found = 0;
+
+    pthread_mutex_lock(&d->lock);
+    if (d->count > 0) {
+        *task = d->ring[d->top];
+        d->top = (d->top + 1) & (d->capacity - 1);
+        d->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return found;
+}
+
+// Finds a task for worker self: its own deque first, then the others in turn
+static int poolFindTask(ThreadPool *pool, int self, Task *task) {
+    if (dequePop(&pool->deques[self], task)) {
+        return 1;
+    }
+    for (int i = 1; i < pool->ndeques; i++) {
+        if (dequeSteal(&pool->deques[(self + i) % pool->ndeques], task)) {
+            __atomic_add_fetch(&pool->steals, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Returns the monotonic clock in seconds
+static double poolClock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Runs a task that has been taken off a deque and retires it; the time is
+// charged to the calling worker (tasks run by other threads are not counted)
+static void poolRun(ThreadPool *pool, const Task *task) {
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    if (current_pool == pool) {
+        WorkerStats *stats = &pool->stats[current_worker];
+        double start = poolClock();
+
+        task->fn(task->arg, task->start, task->end);
+        stats->busy += poolClock() - start;
+        stats->tasks++;
+    } else {
+        task->fn(task->arg, task->start, task->end);
+    }
+    if (task->group != NULL) {
+        __atomic_sub_fetch(&task->group->pending, 1, __ATOMIC_ACQ_REL);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_cond_broadcast(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Spins on the queued count for a while before the worker falls back to sleeping
+static void poolSpin(ThreadPool *pool) {
+    for (int i = 0; i < POOL_SPIN; i++) {
+        if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) > 0 ||
+            __atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+    }
+}
+
+// Worker loop: runs its own tasks, steals when out, sleeps when nothing is queued
+static void *poolWorker(void *arg) {
+    WorkerStart *start = arg;
+    ThreadPool *pool = start->pool;
+    int self = start->index;
+    Task task;
+
+    free(start);
+    current_pool = pool;
+    current_worker = self;
+
+    for (;;) {
+        if (poolFindTask(pool, self, &task)) {
+            poolRun(pool, &task);
+            continue;
+        }
+
+        poolSpin(pool);
+        if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) > 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) <= 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) <= 0 && pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+// Returns the index-th CPU (wrapping around) of the set the process may run on, or -1
+static int poolPickCpu(int index) {
+    cpu_set_t set;
+    int count;
+
+    if (sched_getaffinity(0, sizeof(set), &set) != 0 || (count = CPU_COUNT(&set)) == 0) {
+        return -1;
+    }
+    index %= count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set) && index-- == 0) {
+            return cpu;
+        }
+    }
+    return -1;
+}
+
+// Starts worker i already bound to its CPU, so it never runs (or touches
+// memory) anywhere else; returns -1 without starting it if that fails
+static int poolStartPinned(ThreadPool *pool, int i, WorkerStart *start) {
+    int cpu = poolPickCpu(i);
+    pthread_attr_t attr;
+    cpu_set_t set;
+    int rc;
+
+    if (cpu < 0 || pthread_attr_init(&attr) != 0) {
+        return -1;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    rc = pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    if (rc == 0) {
+        rc = pthread_create(&pool->threads[i], &attr, poolWorker, start);
+    }
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        return -1;
+    }
+    pool->stats[i].cpu = cpu;
+    return 0;
+}
+
+// Allocates the pool and its deques and starts the workers
+ThreadPool *poolCreate(int nthreads, int pin) {
+    ThreadPool *pool;
+    void *stats = NULL;
+
+    if (nthreads <= 0) {
+        return NULL;
+    }
+    pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->threads = malloc(nthreads * sizeof(pthread_t));
+    pool->deques = calloc(nthreads, sizeof(Deque));
+    if (posix_memalign(&stats, sizeof(WorkerStats), nthreads * sizeof(WorkerStats)) != 0) {
+        stats = NULL;
+    }
+    pool->stats = stats;
+    if (pool->threads == NULL || pool->deques == NULL || pool->stats == NULL) {
+        free(pool->threads);
+        free(pool->deques);
+        free(pool->stats);
+        free(pool);
+        return NULL;
+    }
+    memset(pool->stats, 0, nthreads * sizeof(WorkerStats));
+    for (int i = 0; i < nthreads; i++) {
+        pool->stats[i].cpu = -1;
+    }
+    for (int i = 0; i < nthreads; i++) {
+        if (dequeInit(&pool->deques[i]) != 0) {
+            for (int j = 0; j < i; j++) {
+                free(pool->deques[j].ring);
+                pthread_mutex_destroy(&pool->deques[j].lock);
+            }
+            free(pool->threads);
+            free(pool->deques);
+            free(pool->stats);
+            free(pool);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->ndeques = nthreads;
+
+    // Work is only dealt to the workers that actually started
+    for (int i = 0; i < nthreads; i++) {
+        WorkerStart *start = malloc(sizeof(WorkerStart));
+
+        if (start == NULL) {
+            break;
+        }
+        start->pool = pool;
+        start->index = i;
+        if (pin && poolStartPinned(pool, i, start) == 0) {
+            pool->nthreads++;
+            continue;
+        }
+        if (pthread_create(&pool->threads[pool->nthreads], NULL, poolWorker, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->nthreads++;
+    }
+    if (pool->nthreads == 0) {
+        poolDestroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+// Drains the queued work, joins the workers and releases everything
+void poolDestroy(ThreadPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    __atomic_store_n(&pool->shutdown, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nthreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    for (int i = 0; i < pool->ndeques; i++) {
+        free(pool->deques[i].ring);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    free(pool->deques);
+    free(pool->threads);
+    free(pool->stats);
+    free(pool);
+}
+
+// Returns the online CPU count, or 1 if it cannot be read
+int poolDefaultThreads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? (int)n : 1;
+}
+
+// Pushes a task on a deque of a running worker, then wakes one sleeper
+static void poolPush(ThreadPool *pool, int target, const Task *task) {
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL);
+    if (dequePush(&pool->deques[target], task) != 0) {
+        // Out of memory: run the task inline rather than drop it
+        __atomic_add_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+        poolRun(pool, task);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_ACQ_REL);
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Picks the caller's own deque from a worker, otherwise the next one in turn
+static int poolTarget(ThreadPool *pool) {
+    if (current_pool == pool) {
+        return current_worker;
+    }
+    return __atomic_fetch_add(&pool->next_deque, 1, __ATOMIC_RELAXED) % pool->nthreads;
+}
+
+// Queues a task on the caller's deque (from a worker) or the next one in turn
+void poolSubmit(ThreadPool *pool, RangeFn fn, void *arg, int start, int end) {
+    Task task = { fn, arg, start, end, NULL };
+
+    poolPush(pool, poolTarget(pool), &task);
+}
+
+// Queues a task that is counted in group
+void poolGroupSubmit(ThreadPool *pool, TaskGroup *group, RangeFn fn, void *arg,
+                     int start, int end) {
+    Task task = { fn, arg, start, end, group };
+
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_ACQ_REL);
+    poolPush(pool, poolTarget(pool), &task);
+}
+
+// Runs queued tasks, newest first from the caller's own deque, until group is done
+void poolGroupWait(ThreadPool *pool, TaskGroup *group) {
+    int self = current_pool == pool ? current_worker : 0;
+    Task task;
+
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+        if (poolFindTask(pool, self, &task)) {
+            poolRun(pool, &task);
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+// Sleeps until the pending count drops to zero
+void poolWait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Cuts [0, n) into tiles and gives worker w the w-th contiguous run of them.
+// Each run is pushed back to front so its owner pops the tiles in row order.
+void poolSplit(ThreadPool *pool, RangeFn fn, void *arg, int n) {
+    int tiles = pool->nthreads * POOL_TILES_PER_WORKER;
+
+    if (tiles > n) {
+        tiles = n;
+    }
+    for (int w = 0; w < pool->nthreads; w++) {
+        int first = (int)((long)tiles * w / pool->nthreads);
+        int last = (int)((long)tiles * (w + 1) / pool->nthreads);
+
+        for (int t = last - 1; t >= first; t--) {
+            Task task = { fn, arg, (int)((long)n * t / tiles), (int)((long)n * (t + 1) / tiles), NULL };
+            poolPush(pool, w, &task);
+        }
+    }
+}
+
+// Deals precomputed tiles out in contiguous runs, like poolSplit
+void poolSplitRanges(ThreadPool *pool, RangeFn fn, void *arg, const int *bounds, int tiles) {
+    for (int w = 0; w < pool->nthreads; w++) {
+        int first = (int)((long)tiles * w / pool->nthreads);
+        int last = (int)((long)tiles * (w + 1) / pool->nthreads);
+
+        for (int t = last - 1; t >= first; t--) {
+            if (bounds[t] < bounds[t + 1]) {
+                Task task = { fn, arg, bounds[t], bounds[t + 1], NULL };
+                poolPush(pool, w, &task);
+            }
+        }
+    }
+}
+
+// Splits the range across the workers and waits for them
+void poolParallelFor(ThreadPool *pool, RangeFn fn, void *arg, int n) {
+    poolSplit(pool, fn, arg, n);
+    poolWait(pool);
+}
+
+// Clears the per-worker counters between operations
+void poolResetStats(ThreadPool *pool) {
+    for (int i = 0; i < pool->ndeques; i++) {
+        pool->stats[i].busy = 0.0;
+        pool->stats[i].tasks = 0;
+    }
+    pool->steals = 0;
+}
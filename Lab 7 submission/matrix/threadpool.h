@@ -0,0 +1,128 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+/**
+ * Persistent work-stealing worker pool.
+ *
+ * The workers are started once. Each owns a deque of range tasks: it pops
+ * its own work from the bottom (most recently pushed, still warm in cache)
+ * and, when that runs dry, steals from the top of another worker's deque
+ * (the oldest, usually largest, piece). A range operation is cut into
+ * several tiles per worker and dealt out in contiguous runs, so every
+ * worker starts on its own rows and the stragglers' leftovers are balanced
+ * by stealing instead of a static split.
+ *
+ * An idle worker spins briefly on the queued count before parking on a
+ * condition variable, so back-to-back small operations are picked up
+ * without a wakeup. Tasks are stored by value; submitting work allocates
+ * nothing once the deques have grown to their working size.
+ *
+ * Workers can be pinned to CPUs so that each stays next to the memory it
+ * touched first (and so on the local NUMA node). Each worker also counts
+ * the time it spends running tasks, to show how evenly an operation was
+ * spread.
+ */
+
+/* Spin iterations an idle worker polls for work before it sleeps. */
+#define POOL_SPIN 2000
+
+/* Tiles each worker gets from poolSplit; the surplus is what gets stolen. */
+#define POOL_TILES_PER_WORKER 4
+
+/* Work on rows (or any index range) [start, end). */
+typedef void (*RangeFn)(void *arg, int start, int end);
+
+/* Counts the unfinished tasks of one fork-join step, so a task can wait for
+ * the subtasks it spawned without waiting for the whole pool. */
+typedef struct {
+    int pending;
+} TaskGroup;
+
+typedef struct {
+    RangeFn fn;
+    void *arg;
+    int start;
+    int end;
+    TaskGroup *group;           // NULL for tasks outside any group
+} Task;
+
+/* One worker's task deque: the owner uses the bottom, thieves the top. */
+typedef struct {
+    pthread_mutex_t lock;
+    Task *ring;
+    int capacity;               // power of two
+    int top;                    // oldest task
+    int count;
+} Deque;
+
+/* Per-worker counters, each on its own cache line; only the worker writes them. */
+typedef struct {
+    double busy;                // seconds spent running tasks
+    long tasks;
+    int cpu;                    // CPU the worker is pinned to, or -1
+} __attribute__((aligned(64))) WorkerStats;
+
+typedef struct {
+    pthread_t *threads;
+    int nthreads;               // workers running
+    Deque *deques;              // one per worker
+    int ndeques;                // deques allocated (workers requested)
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // signalled when tasks are queued or on shutdown
+    pthread_cond_t done;        // signalled when the last pending task finishes
+
+    int queued;                 // tasks sitting in any deque, read while spinning
+    int pending;                // queued plus running
+    int next_deque;             // round-robin target for submissions from outside
+    long steals;                // tasks taken from another worker's deque
+    WorkerStats *stats;         // one per worker
+    int shutdown;
+} ThreadPool;
+
+/* Starts nthreads workers; returns NULL on failure. With pin, worker i is
+ * bound to the i-th CPU the process may run on (wrapping around). */
+ThreadPool *poolCreate(int nthreads, int pin);
+
+/* Finishes the queued work, stops the workers and frees the pool. */
+void poolDestroy(ThreadPool *pool);
+
+/* Number of online CPUs, the default pool size. */
+int poolDefaultThreads(void);
+
+/* Queues fn(arg, start, end): on the caller's own deque when called from a
+ * worker, otherwise on the next deque in turn. */
+void poolSubmit(ThreadPool *pool, RangeFn fn, void *arg, int start, int end);
+
+/* Blocks until every submitted task has finished. */
+void poolWait(ThreadPool *pool);
+
+/* Like poolSubmit, but the task is counted in group (zero-initialized by
+ * the caller). Workers and the main thread may both fork groups. */
+void poolGroupSubmit(ThreadPool *pool, TaskGroup *group, RangeFn fn, void *arg,
+                     int start, int end);
+
+/* Waits for every task of group, running queued tasks meanwhile so that a
+ * worker blocked here keeps the pool busy instead of deadlocking it. */
+void poolGroupWait(ThreadPool *pool, TaskGroup *group);
+
+/* Cuts [0, n) into POOL_TILES_PER_WORKER tiles per worker, deals them out
+ * in contiguous runs and returns without waiting, so several operations
+ * can share the workers. */
+void poolSplit(ThreadPool *pool, RangeFn fn, void *arg, int n);
+
+/* Like poolSplit, but with caller-chosen tiles: tile t is [bounds[t],
+ * bounds[t + 1]) for t in [0, tiles), so uneven rows can be balanced by
+ * their actual work. Empty tiles are skipped. */
+void poolSplitRanges(ThreadPool *pool, RangeFn fn, void *arg, const int *bounds, int tiles);
+
+/* poolSplit followed by poolWait. */
+void poolParallelFor(ThreadPool *pool, RangeFn fn, void *arg, int n);
+
+/* Zeroes the per-worker busy times and task counts and the steal count;
+ * call while idle. */
+void poolResetStats(ThreadPool *pool);
+
+#endif				// THREADPOOL_H
@@ -0,0 +1,77 @@
+#include "transpose.h"
+
+// The operands of one transpose
+typedef struct {
+    const Matrix *src;
+    Matrix *dst;
+} TransposeJob;
+
+// Transposes tile rows [start, end) of src into the matching tile columns of dst
+static void transposeTiles(void *arg, int start, int end) {
+    TransposeJob *job = arg;
+    const Matrix *src = job->src;
+    Matrix *dst = job->dst;
+
+    for (int ii = start * TRANSPOSE_TILE; ii < end * TRANSPOSE_TILE && ii < src->rows;
+         ii += TRANSPOSE_TILE) {
+        int i1 = ii + TRANSPOSE_TILE < src->rows ? ii + TRANSPOSE_TILE : src->rows;
+
+        for (int jj = 0; jj < src->cols; jj += TRANSPOSE_TILE) {
+            int j1 = jj + TRANSPOSE_TILE < src->cols ? jj + TRANSPOSE_TILE : src->cols;
+
+            for (int i = ii; i < i1; i++) {
+                for (int j = jj; j < j1; j++) {
+                    MAT(dst, j, i) = MAT(src, i, j);
+                }
+            }
+        }
+    }
+}
+
+// Writes the transpose of src into dst, one task per range of tile rows
+void matrixTranspose(ThreadPool *pool, const Matrix *src, Matrix *dst) {
+    TransposeJob job = { src, dst };
+
+    poolParallelFor(pool, transposeTiles, &job,
+                    (src->rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE);
+}
+
+// For each assigned tile row I, transposes the diagonal tile in place and
+// swaps every tile (I, J) right of it with the transpose of tile (J, I).
+// Tile row I owns exactly the pairs with J >= I, so the tasks never overlap.
+static void transposeInPlaceTiles(void *arg, int start, int end) {
+    TransposeJob *job = arg;
+    Matrix *m = job->dst;
+    int n = m->rows;
+
+    for (int ii = start * TRANSPOSE_TILE; ii < end * TRANSPOSE_TILE && ii < n;
+         ii += TRANSPOSE_TILE) {
+        int i1 = ii + TRANSPOSE_TILE < n ? ii + TRANSPOSE_TILE : n;
+
+        for (int jj = ii; jj < n; jj += TRANSPOSE_TILE) {
+            int j1 = jj + TRANSPOSE_TILE < n ? jj + TRANSPOSE_TILE : n;
+
+            for (int i = ii; i < i1; i++) {
+                // On the diagonal tile only the upper triangle is swapped
+                for (int j = jj == ii ? i + 1 : jj; j < j1; j++) {
+                    int v = MAT(m, i, j);
+
+                    MAT(m, i, j) = MAT(m, j, i);
+                    MAT(m, j, i) = v;
+                }
+            }
+        }
+    }
+}
+
+// Transposes a square matrix in place; returns -1 if it is not square
+int matrixTransposeInPlace(ThreadPool *pool, Matrix *m) {
+    TransposeJob job = { m, m };
+
+    if (m->rows != m->cols) {
+        return -1;
+    }
+    poolParallelFor(pool, transposeInPlaceTiles, &job,
+                    (m->rows + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE);
+    return 0;
+}
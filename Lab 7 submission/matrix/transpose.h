@@ -0,0 +1,27 @@
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include "dense.h"
+#include "threadpool.h"
+
+/**
+ * Cache-blocked transpose.
+ *
+ * A plain transpose reads one matrix along rows and writes the other down
+ * columns, touching a new cache line (and soon a new page) per element.
+ * Working in TRANSPOSE_TILE x TRANSPOSE_TILE tiles keeps the lines of both
+ * tiles in L1 while each is used completely. The workers split the tile
+ * rows between them.
+ */
+
+/* 32 x 32 ints: two tiles are 8 KiB, well within L1. */
+#define TRANSPOSE_TILE 32
+
+/* dst = src^T; dst must be src->cols x src->rows and must not overlap src. */
+void matrixTranspose(ThreadPool *pool, const Matrix *src, Matrix *dst);
+
+/* Transposes a square matrix in place by swapping mirrored tiles across
+ * the diagonal. Returns -1 (and leaves m alone) if m is not square. */
+int matrixTransposeInPlace(ThreadPool *pool, Matrix *m);
+
+#endif				// TRANSPOSE_H
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matmul.h"
+#include "typed.h"
+
+/* T is the element type and U the type the arithmetic is done in: the
+ * unsigned twin for the ints, so an overflowing sum wraps instead of being
+ * undefined. Generic vectors of U load and store through element pointers
+ * (may_alias) at any element alignment; the tail of a row that does not fill
+ * a vector is done one element at a time. Tiles are sized in bytes like the
+ * int kernel's, so 8-byte types get half as many columns per B panel. */
+#define DEFINE_TYPED_KERNELS(SFX, T, U) \
+typedef U vec##SFX __attribute__((vector_size(TYPED_VECTOR_BYTES), aligned(sizeof(T)), may_alias)); \
+enum { \
+    LANES_##SFX = TYPED_VECTOR_BYTES / sizeof(T), \
+    TILE_J_##SFX = TILE_J * sizeof(int) / sizeof(T) \
+}; \
+\
+static void tile4##SFX(const T *A, int lda, const T *B, int ldb, T *C, int ldc, \
+                       int i0, int k0, int k1, int j0, int j1) { \
+    T *restrict c0 = C + (size_t)(i0 + 0) * ldc; \
+    T *restrict c1 = C + (size_t)(i0 + 1) * ldc; \
+    T *restrict c2 = C + (size_t)(i0 + 2) * ldc; \
+    T *restrict c3 = C + (size_t)(i0 + 3) * ldc; \
+    int jv = j0 + (j1 - j0) / LANES_##SFX * LANES_##SFX; \
+\
+    for (int p = k0; p < k1; p++) { \
+        const T *restrict b = B + (size_t)p * ldb; \
+        U a0 = A[(size_t)(i0 + 0) * lda + p]; \
+        U a1 = A[(size_t)(i0 + 1) * lda + p]; \
+        U a2 = A[(size_t)(i0 + 2) * lda + p]; \
+        U a3 = A[(size_t)(i0 + 3) * lda + p]; \
+        int j = j0; \
+\
+        for (; j < jv; j += LANES_##SFX) { \
+            vec##SFX bj = *(const vec##SFX *)(b + j); \
+            *(vec##SFX *)(c0 + j) += a0 * bj; \
+            *(vec##SFX *)(c1 + j) += a1 * bj; \
+            *(vec##SFX *)(c2 + j) += a2 * bj; \
+            *(vec##SFX *)(c3 + j) += a3 * bj; \
+        } \
+        for (; j < j1; j++) { \
+            c0[j] = (T)((U)c0[j] + a0 * (U)b[j]); \
+            c1[j] = (T)((U)c1[j] + a1 * (U)b[j]); \
+            c2[j] = (T)((U)c2[j] + a2 * (U)b[j]); \
+            c3[j] = (T)((U)c3[j] + a3 * (U)b[j]); \
+        } \
+    } \
+} \
+\
+static void tile1##SFX(const T *A, int lda, const T *B, int ldb, T *C, int ldc, \
+                       int i, int k0, int k1, int j0, int j1) { \
+    T *restrict c = C + (size_t)i * ldc; \
+    int jv = j0 + (j1 - j0) / LANES_##SFX * LANES_##SFX; \
+\
+    for (int p = k0; p < k1; p++) { \
+        const T *restrict b = B + (size_t)p * ldb; \
+        U a = A[(size_t)i * lda + p]; \
+        int j = j0; \
+\
+        for (; j < jv; j += LANES_##SFX) { \
+            *(vec##SFX *)(c + j) += a * *(const vec##SFX *)(b + j); \
+        } \
+        for (; j < j1; j++) { \
+            c[j] = (T)((U)c[j] + a * (U)b[j]); \
+        } \
+    } \
+} \
+\
+void matmulBlocked##SFX(const T *A, int lda, const T *B, int ldb, T *C, int ldc, \
+                        int row_start, int row_end, int n, int k) { \
+    for (int i = row_start; i < row_end; i++) { \
+        memset(C + (size_t)i * ldc, 0, n * sizeof(T)); \
+    } \
+    for (int jj = 0; jj < n; jj += TILE_J_##SFX) { \
+        int j1 = jj + TILE_J_##SFX < n ? jj + TILE_J_##SFX : n; \
+\
+        for (int kk = 0; kk < k; kk += TILE_K) { \
+            int k1 = kk + TILE_K < k ? kk + TILE_K : k; \
+\
+            for (int ii = row_start; ii < row_end; ii += TILE_I) { \
+                int i1 = ii + TILE_I < row_end ? ii + TILE_I : row_end; \
+                int i = ii; \
+\
+                for (; i + 4 <= i1; i += 4) { \
+                    tile4##SFX(A, lda, B, ldb, C, ldc, i, kk, k1, jj, j1); \
+                } \
+                for (; i < i1; i++) { \
+                    tile1##SFX(A, lda, B, ldb, C, ldc, i, kk, k1, jj, j1); \
+                } \
+            } \
+        } \
+    } \
+} \
+\
+void sumDiffRow##SFX(const T *a, const T *b, T *sum, T *diff, int n) { \
+    int jv = n / LANES_##SFX * LANES_##SFX; \
+    int j = 0; \
+\
+    for (; j < jv; j += LANES_##SFX) { \
+        vec##SFX x = *(const vec##SFX *)(a + j); \
+        vec##SFX y = *(const vec##SFX *)(b + j); \
+        *(vec##SFX *)(sum + j) = x + y; \
+        *(vec##SFX *)(diff + j) = x - y; \
+    } \
+    for (; j < n; j++) { \
+        sum[j] = (T)((U)a[j] + (U)b[j]); \
+        diff[j] = (T)((U)a[j] - (U)b[j]); \
+    } \
+}
+
+DEFINE_TYPED_KERNELS(I32, int32_t, uint32_t)
+DEFINE_TYPED_KERNELS(I64, int64_t, uint64_t)
+DEFINE_TYPED_KERNELS(F32, float, float)
+DEFINE_TYPED_KERNELS(F64, double, double)
+
+// Four int32 lanes widened to four int64 lanes
+typedef int32_t v4i32 __attribute__((vector_size(16), aligned(4), may_alias));
+typedef int64_t v4i64 __attribute__((vector_size(32), aligned(8), may_alias));
+
+// Adds A[i0..i0+rows)[k0..k1) * B[k0..k1)[j0..j1) into int64 rows of C (rows is 1 or 4)
+static void widenTile(const int32_t *A, int lda, const int32_t *B, int ldb, int64_t *C, int ldc,
+                      int i0, int rows, int k0, int k1, int j0, int j1) {
+    int jv = j0 + (j1 - j0) / 4 * 4;
+
+    for (int p = k0; p < k1; p++) {
+        const int32_t *restrict b = B + (size_t)p * ldb;
+
+        for (int r = 0; r < rows; r++) {
+            int64_t *restrict c = C + (size_t)(i0 + r) * ldc;
+            int64_t a = A[(size_t)(i0 + r) * lda + p];
+            int j = j0;
+
+            for (; j < jv; j += 4) {
+                *(v4i64 *)(c + j) += a * __builtin_convertvector(*(const v4i32 *)(b + j), v4i64);
+            }
+            for (; j < j1; j++) {
+                c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// Adds rows [row_start, row_end) x columns [j0, j1) of A * B into int64 C over all of k
+static void widenBlock(const int32_t *A, int lda, const int32_t *B, int ldb, int64_t *C, int ldc,
+                       int row_start, int row_end, int j0, int j1, int k) {
+    for (int kk = 0; kk < k; kk += TILE_K) {
+        int k1 = kk + TILE_K < k ? kk + TILE_K : k;
+
+        for (int ii = row_start; ii < row_end; ii += TILE_I) {
+            int i1 = ii + TILE_I < row_end ? ii + TILE_I : row_end;
+            int i = ii;
+
+            for (; i + 4 <= i1; i += 4) {
+                widenTile(A, lda, B, ldb, C, ldc, i, 4, kk, k1, j0, j1);
+            }
+            for (; i < i1; i++) {
+                widenTile(A, lda, B, ldb, C, ldc, i, 1, kk, k1, j0, j1);
+            }
+        }
+    }
+}
+
+// Largest |x| over a rows x cols int32 block (2^31 for INT32_MIN)
+static int64_t maxAbsI32(const int32_t *X, int ld, int rows, int cols) {
+    int32_t lo = 0, hi = 0;
+
+    // Plain int32 min and max vectorize; the magnitude is taken once at the end
+    for (int i = 0; i < rows; i++) {
+        const int32_t *x = X + (size_t)i * ld;
+
+        for (int j = 0; j < cols; j++) {
+            lo = x[j] < lo ? x[j] : lo;
+            hi = x[j] > hi ? x[j] : hi;
+        }
+    }
+    return -(int64_t)lo > hi ? -(int64_t)lo : hi;
+}
+
+// Returns 1 if k products bounded by a_max * b_max (each at most 2^62) cannot
+// overflow an int64 partial sum
+static int widenFits(int64_t a_max, int64_t b_max, int k) {
+    int64_t bound = a_max * b_max;
+
+    return bound == 0 || k <= INT64_MAX / bound;
+}
+
+// Exact dot product of one row of A with column j of B
+static __int128 dotExactI32(const int32_t *a, const int32_t *B, int ldb, int j, int k) {
+    __int128 sum = 0;
+
+    for (int p = 0; p < k; p++) {
+        sum += (int64_t)a[p] * B[(size_t)p * ldb + j];
+    }
+    return sum;
+}
+
+// Clamps an exact sum to the int64 range
+static int64_t clampI64(__int128 x) {
+    return x > INT64_MAX ? INT64_MAX : x < INT64_MIN ? INT64_MIN : (int64_t)x;
+}
+
+// Clamps an exact sum to the int32 range
+static int32_t clampI32(__int128 x) {
+    return x > INT32_MAX ? INT32_MAX : x < INT32_MIN ? INT32_MIN : (int32_t)x;
+}
+
+// Exact int64-clamped rows [i0, i1) x columns [j0, j1) of A * B, for blocks where
+// int64 sums could overflow; kept out of line so the vectorized path stays lean
+static void __attribute__((noinline))
+exactBlockI64(const int32_t *A, int lda, const int32_t *B, int ldb, int64_t *C, int ldc,
+              int i0, int i1, int j0, int j1, int k) {
+    for (int i = i0; i < i1; i++) {
+        for (int j = j0; j < j1; j++) {
+            C[(size_t)i * ldc + j] = clampI64(dotExactI32(A + (size_t)i * lda, B, ldb, j, k));
+        }
+    }
+}
+
+// The same block clamped to the int32 range
+static void __attribute__((noinline))
+exactBlockI32(const int32_t *A, int lda, const int32_t *B, int ldb, int32_t *C, int ldc,
+              int i0, int i1, int j0, int j1, int k) {
+    for (int i = i0; i < i1; i++) {
+        for (int j = j0; j < j1; j++) {
+            C[(size_t)i * ldc + j] = clampI32(dotExactI32(A + (size_t)i * lda, B, ldb, j, k));
+        }
+    }
+}
+
+// Computes rows [row_start, row_end) of the int64 product of int32 matrices: vectorized
+// in int64 where the operand magnitudes rule out overflow, exactly in 128 bits elsewhere
+void matmulWidenI32(const int32_t *A, int lda, const int32_t *B, int ldb, int64_t *C, int ldc,
+                    int row_start, int row_end, int n, int k) {
+    int64_t a_max = maxAbsI32(A + (size_t)row_start * lda, lda, row_end - row_start, k);
+
+    for (int i = row_start; i < row_end; i++) {
+        memset(C + (size_t)i * ldc, 0, n * sizeof(int64_t));
+    }
+    for (int jj = 0; jj < n; jj += TILE_J_I64) {
+        int j1 = jj + TILE_J_I64 < n ? jj + TILE_J_I64 : n;
+
+        if (widenFits(a_max, maxAbsI32(B + jj, ldb, k, j1 - jj), k)) {
+            widenBlock(A, lda, B, ldb, C, ldc, row_start, row_end, jj, j1, k);
+        } else {
+            exactBlockI64(A, lda, B, ldb, C, ldc, row_start, row_end, jj, j1, k);
+        }
+    }
+}
+
+// Computes rows [row_start, row_end) of A * B exactly, one TILE_I x TILE_J_I64 block
+// of C at a time (in an int64 scratch block, or in 128 bits where int64 could
+// overflow), and stores the clamped sums; returns -1 if the scratch block cannot
+// be allocated
+int matmulSaturateI32(const int32_t *A, int lda, const int32_t *B, int ldb, int32_t *C, int ldc,
+                      int row_start, int row_end, int n, int k) {
+    int64_t *scratch = malloc((size_t)TILE_I * TILE_J_I64 * sizeof(int64_t));
+
+    if (scratch == NULL) {
+        return -1;
+    }
+    for (int ii = row_start; ii < row_end; ii += TILE_I) {
+        int rows = (ii + TILE_I < row_end ? ii + TILE_I : row_end) - ii;
+        int64_t a_max = maxAbsI32(A + (size_t)ii * lda, lda, rows, k);
+
+        for (int jj = 0; jj < n; jj += TILE_J_I64) {
+            int cols = (jj + TILE_J_I64 < n ? jj + TILE_J_I64 : n) - jj;
+
+            if (!widenFits(a_max, maxAbsI32(B + jj, ldb, k, cols), k)) {
+                exactBlockI32(A, lda, B, ldb, C, ldc, ii, ii + rows, jj, jj + cols, k);
+                continue;
+            }
+            memset(scratch, 0, (size_t)TILE_I * TILE_J_I64 * sizeof(int64_t));
+            widenBlock(A + (size_t)ii * lda, lda, B + jj, ldb, scratch, TILE_J_I64,
+                       0, rows, 0, cols, k);
+            for (int i = 0; i < rows; i++) {
+                int32_t *c = C + (size_t)(ii + i) * ldc + jj;
+                const int64_t *s = scratch + (size_t)i * TILE_J_I64;
+
+                for (int j = 0; j < cols; j++) {
+                    c[j] = s[j] > INT32_MAX ? INT32_MAX : s[j] < INT32_MIN ? INT32_MIN : (int32_t)s[j];
+                }
+            }
+        }
+    }
+    free(scratch);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef TYPED_H
+#define TYPED_H
+
+#include <stdint.h>
+
+/**
+ * Kernels for other element types.
+ *
+ * The int kernels in matmul.h and elementwise.h are written out by hand;
+ * these are stamped out once per type by DEFINE_TYPED_KERNELS in typed.c,
+ * so every type gets its own fully specialized blocked multiply and fused
+ * sum/difference with a vector of TYPED_VECTOR_BYTES (8 x int32/float,
+ * 4 x int64/double). Buffers use the same row-major + leading dimension
+ * layout as matmul.h, with ld counted in elements of the buffer's type.
+ *
+ * The int kernels wrap around on overflow like unsigned arithmetic, and
+ * int32 products overflow easily; two extra kernels avoid that:
+ * matmulWidenI32 stores in int64, and matmulSaturateI32 clamps the final
+ * sums to the int32 range. Both accumulate in vectorized int64 for blocks
+ * whose largest |a| * |b| * k fits in int64 and fall back to exact 128-bit
+ * sums elsewhere, since two full-range int32 products already overflow it.
+ */
+
+#define TYPED_VECTOR_BYTES 32
+
+#define DECLARE_TYPED_KERNELS(SFX, T) \
+    void matmulBlocked##SFX(const T *A, int lda, const T *B, int ldb, T *C, int ldc, \
+                            int row_start, int row_end, int n, int k); \
+    void sumDiffRow##SFX(const T *a, const T *b, T *sum, T *diff, int n);
+
+DECLARE_TYPED_KERNELS(I32, int32_t)
+DECLARE_TYPED_KERNELS(I64, int64_t)
+DECLARE_TYPED_KERNELS(F32, float)
+DECLARE_TYPED_KERNELS(F64, double)
+
+/* C (int64) = A * B for int32 A and B. Each sum is exact, then clamped to
+ * [INT64_MIN, INT64_MAX], which only operands near the int32 limits reach. */
+void matmulWidenI32(const int32_t *A, int lda, const int32_t *B, int ldb, int64_t *C, int ldc,
+                    int row_start, int row_end, int n, int k);
+
+/* C = A * B with each exact sum clamped to [INT32_MIN, INT32_MAX].
+ * Returns 0, or -1 (with C unwritten) if scratch space cannot be allocated. */
+int matmulSaturateI32(const int32_t *A, int lda, const int32_t *B, int ldb, int32_t *C, int ldc,
+                      int row_start, int row_end, int n, int k);
+
+#endif				// TYPED_H
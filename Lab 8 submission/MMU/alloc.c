@@ -0,0 +1,516 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "list.h"
+#include "alloc.h"
+
+// Short names used in reports, indexed by policy number
+static const char *policy_names[POLICY_COUNT + 1] = {
+    "NONE", "FIRSTFIT", "BESTFIT", "WORSTFIT", "NEXTFIT", "HUGEPAGE"
+};
+
+// Returns the report name of a policy
+const char *policy_name(int policy) {
+    if (policy < 1 || policy > POLICY_COUNT)
+        return policy_names[0];
+    return policy_names[policy];
+}
+
+// Inserts a free block in address order, merging it with adjacent free blocks
+static void free_list_insert_coalesced(list_t *freelist, block_t *blk) {
+    node_t *prev = NULL;
+    node_t *current = freelist->head;
+
+    while (current != NULL && current->blk->start < blk->start) {
+        prev = current;
+        current = current->next;
+    }
+
+    if (prev != NULL && prev->blk->end + 1 == blk->start) {
+        prev->blk->end = blk->end;
+        block_free(blk);
+        if (current != NULL && prev->blk->end + 1 == current->blk->start) {
+            prev->blk->end = current->blk->end;
+            block_free(list_unlink(freelist, current->blk));
+        }
+        return;
+    }
+
+    if (current != NULL && blk->end + 1 == current->blk->start) {
+        current->blk->start = blk->start;
+        block_free(blk);
+        return;
+    }
+
+    list_add_ascending_by_address(freelist, blk);
+}
+
+// Adds a free block to the free list in the order the policy expects
+static void free_list_insert(list_t *freelist, block_t *blk, int policy) {
+    if (policy == POLICY_HUGE_PAGE) {
+        free_list_insert_coalesced(freelist, blk);
+    } else if (policy == POLICY_FIRST_FIT) {
+        list_add_to_back(freelist, blk);
+    } else if (policy == POLICY_NEXT_FIT) {
+        list_add_ascending_by_address(freelist, blk);
+    } else if (policy == POLICY_BEST_FIT) {
+        list_add_ascending_by_blocksize(freelist, blk);
+    } else {
+        list_add_descending_by_blocksize(freelist, blk);
+    }
+}
+
+// Next fit: resumes the scan at the free list's rover and wraps around once.
+// The free list is address ordered, so a split leaves the remainder in place.
+static int next_fit_memory(list_t *freelist, list_t *alloclist, int pid, int blocksize, int *scanned) {
+    node_t *start = freelist->rover != NULL ? freelist->rover : freelist->head;
+    node_t *current = start;
+    block_t *blk;
+    int visited = 0;
+
+    while (current != NULL) {
+        visited++;
+        if (current->blk->end - current->blk->start + 1 >= blocksize)
+            break;
+
+        current = current->next != NULL ? current->next : freelist->head;
+        if (current == start) {
+            current = NULL; // Wrapped all the way around
+        }
+    }
+
+    if (scanned != NULL)
+        *scanned = visited;
+    if (current == NULL)
+        return 0;
+
+    if (current->blk->end - current->blk->start + 1 > blocksize) {
+        // Carve the allocation off the front and keep the rover on the remainder
+        blk = block_alloc();
+        blk->start = current->blk->start;
+        blk->end = blk->start + blocksize - 1;
+        current->blk->start += blocksize;
+        freelist->rover = current;
+    } else {
+        // Exact fit: the whole block leaves the free list, the rover moves on
+        freelist->rover = current;
+        blk = list_unlink(freelist, current->blk);
+    }
+
+    blk->pid = pid;
+    list_add_ascending_by_address(alloclist, blk);
+    return blocksize;
+}
+
+int hugepage_init(huge_page_t *hp, int partition_size, int huge_size, int threshold) {
+    hp->huge_size = huge_size > 0 ? huge_size : HUGE_PAGE_SIZE;
+    hp->threshold = threshold > 0 ? threshold : hp->huge_size / 2;
+    hp->nregions = partition_size / hp->huge_size;
+    hp->broken = calloc(hp->nregions > 0 ? hp->nregions : 1, 1);
+    hp->huge_allocs = 0;
+    hp->small_allocs = 0;
+    hp->align_waste = 0;
+    hp->regions_broken = 0;
+    hp->regions_reclaimed = 0;
+    return hp->broken != NULL ? 0 : -1;
+}
+
+void hugepage_destroy(huge_page_t *hp) {
+    free(hp->broken);
+    hp->broken = NULL;
+}
+
+// 1 if region k is in the small-page pool. The partial region at the top of
+// the partition can never hold a huge page, so it always is.
+static int in_small_pool(const huge_page_t *hp, long long k) {
+    return k >= hp->nregions || hp->broken[k];
+}
+
+// Lowest start of blocksize small-pool bytes inside the free block fb, or -1
+static long long small_pool_fit(const huge_page_t *hp, const block_t *fb, int blocksize) {
+    long long k, lo, hi, run = -1;
+    int H = hp->huge_size;
+
+    for (k = fb->start / H; k <= fb->end / H; k++) {
+        if (!in_small_pool(hp, k)) {
+            run = -1;
+            continue;
+        }
+        lo = k * H > fb->start ? k * H : fb->start;
+        hi = (k + 1) * H - 1 < fb->end ? (k + 1) * H - 1 : fb->end;
+        if (run < 0)
+            run = lo;
+        if (hi - run + 1 >= blocksize)
+            return run;
+    }
+    return -1;
+}
+
+// Lowest huge-page aligned start of rounded bytes of intact regions inside fb, or -1
+static long long huge_pool_fit(const huge_page_t *hp, const block_t *fb, long long rounded) {
+    long long at, k, last;
+    int H = hp->huge_size;
+
+    for (at = ((long long)fb->start + H - 1) / H * H; at + rounded - 1 <= fb->end; at = (k + 1) * H) {
+        last = (at + rounded) / H;
+        for (k = at / H; k < last && !in_small_pool(hp, k); k++)
+            ;
+        if (k == last)
+            return at;
+    }
+    return -1;
+}
+
+// Moves broken regions that lie entirely in free blocks back to the huge-page pool
+static long reclaim_regions(list_t *freelist, huge_page_t *hp) {
+    node_t *current;
+    long long k, first, last;
+    long n = 0;
+    int H = hp->huge_size;
+
+    for (current = freelist->head; current != NULL; current = current->next) {
+        first = ((long long)current->blk->start + H - 1) / H;
+        last = ((long long)current->blk->end + 1) / H - 1;
+        for (k = first; k <= last && k < hp->nregions; k++) {
+            if (hp->broken[k]) {
+                hp->broken[k] = 0;
+                n++;
+            }
+        }
+    }
+    hp->regions_reclaimed += n;
+    return n;
+}
+
+// Cuts [start, start+len-1] out of the free block held by node and returns it as a new block
+static block_t *carve(list_t *freelist, node_t *node, int start, int len) {
+    block_t *fb = node->blk;
+    block_t *blk, *tail;
+    int fb_end = fb->end;
+
+    if (start == fb->start && start + len - 1 == fb_end)
+        return list_unlink(freelist, fb);
+
+    blk = block_alloc();
+    blk->start = start;
+    blk->end = start + len - 1;
+
+    if (start == fb->start) {
+        fb->start += len;
+    } else {
+        fb->end = start - 1;
+        if (blk->end < fb_end) {
+            tail = block_alloc();
+            tail->start = blk->end + 1;
+            tail->end = fb_end;
+            list_add_ascending_by_address(freelist, tail);
+        }
+    }
+    return blk;
+}
+
+int allocate_huge(list_t *freelist, list_t *alloclist, int pid, int blocksize,
+                  huge_page_t *hp, int *scanned) {
+    node_t *current, *fallback = NULL;
+    block_t *blk = NULL;
+    long long rounded, at = -1, k;
+    int H = hp->huge_size, visited = 0, retried = 0;
+
+    if (blocksize >= hp->threshold) {
+        // Large request: whole huge pages on a huge-page boundary, from intact
+        // regions only. If none fit, take back empty broken regions once.
+        rounded = ((long long)blocksize + H - 1) / H * H;
+        do {
+            for (current = freelist->head; current != NULL; current = current->next) {
+                visited++;
+                if ((at = huge_pool_fit(hp, current->blk, rounded)) >= 0)
+                    break;
+            }
+        } while (current == NULL && !retried++ && reclaim_regions(freelist, hp) > 0);
+
+        if (current != NULL) {
+            blk = carve(freelist, current, (int)at, (int)rounded);
+            hp->huge_allocs++;
+            hp->align_waste += rounded - blocksize;
+        }
+    } else {
+        // Small request: the small-page pool only, breaking the intact
+        // regions under the lowest fit when the pool has no room
+        for (current = freelist->head; current != NULL; current = current->next) {
+            visited++;
+            if (current->blk->end - current->blk->start + 1 < blocksize)
+                continue;
+            if ((at = small_pool_fit(hp, current->blk, blocksize)) >= 0)
+                break;
+            if (fallback == NULL)
+                fallback = current;
+        }
+
+        if (current == NULL && fallback != NULL) {
+            current = fallback;
+            at = current->blk->start;
+            for (k = at / H; k <= (at + blocksize - 1) / H; k++) {
+                if (!in_small_pool(hp, k)) {
+                    hp->broken[k] = 1;
+                    hp->regions_broken++;
+                }
+            }
+        }
+        if (current != NULL) {
+            blk = carve(freelist, current, (int)at, blocksize);
+            hp->small_allocs++;
+        }
+    }
+
+    if (scanned != NULL)
+        *scanned = visited;
+    if (blk == NULL)
+        return 0;
+
+    blk->pid = pid;
+    list_add_ascending_by_address(alloclist, blk);
+    return blk->end - blk->start + 1;
+}
+
+long hugepage_free_regions(list_t *freelist, const huge_page_t *hp) {
+    node_t *current;
+    long long k, first, last;
+    long n = 0;
+    int H = hp->huge_size;
+
+    for (current = freelist->head; current != NULL; current = current->next) {
+        first = ((long long)current->blk->start + H - 1) / H;
+        last = ((long long)current->blk->end + 1) / H - 1;
+        for (k = first; k <= last; k++)
+            n += !in_small_pool(hp, k);
+    }
+    return n;
+}
+
+// Allocates memory to a process based on the specified policy.
+// Returns the allocated size, or 0 if no free block is large enough.
+// If scanned is not NULL it receives the number of free blocks examined.
+int allocate_memory(list_t *freelist, list_t *alloclist, int pid, int blocksize, int policy, int *scanned) {
+    /* Steps:
+     * 1. Find a suitable block in the free list based on the allocation policy.
+     * 2. If found:
+     *      - Remove it from the free list.
+     *      - Assign it to the process with the given PID.
+     *      - Adjust the block size and handle fragmentation (if any).
+     *      - Add the allocated block to the allocated list.
+     * 3. If no suitable block is found, report failure to the caller.
+     */
+
+    node_t *current = freelist->head;
+    node_t *best = NULL;
+    block_t *blk;
+    int best_size = -1;
+    int current_size;
+    int visited = 0;
+
+    if (policy == POLICY_NEXT_FIT)
+        return next_fit_memory(freelist, alloclist, pid, blocksize, scanned);
+    if (policy == POLICY_HUGE_PAGE) {
+        // Huge pages keep their state in the caller's huge_page_t; see allocate_huge
+        if (scanned != NULL)
+            *scanned = 0;
+        return 0;
+    }
+
+    // Traverse the free list to find the most suitable block based on the policy
+    while (current != NULL) {
+        current_size = current->blk->end - current->blk->start + 1;
+        visited++;
+
+        if (current_size >= blocksize) {
+            switch (policy) {
+                case POLICY_FIRST_FIT: // First Fit: Select the first block that fits
+                    best = current;
+                    goto found;
+                case POLICY_BEST_FIT: // Best Fit: Select the smallest block that fits
+                    if (best == NULL || current_size < best_size) {
+                        best = current;
+                        best_size = current_size;
+                    }
+                    break;
+                case POLICY_WORST_FIT: // Worst Fit: Select the largest block that fits
+                    if (best == NULL || current_size > best_size) {
+                        best = current;
+                        best_size = current_size;
+                    }
+                    break;
+            }
+        }
+        current = current->next;
+    }
+
+found:
+    if (scanned != NULL)
+        *scanned = visited;
+
+    if (best == NULL) {
+        // No suitable block found
+        return 0;
+    }
+
+    // Remove the selected block from the free list
+    blk = list_unlink(freelist, best->blk);
+
+    // Handle leftover memory as a fragment if the block is larger than requested
+    if ((blk->end - blk->start + 1) > blocksize) {
+        block_t *fragment = block_alloc();
+        fragment->start = blk->start + blocksize;
+        fragment->end = blk->end;
+        fragment->pid = 0; // Fragment belongs to no process
+
+        // Add the fragment back to the free list based on the policy
+        free_list_insert(freelist, fragment, policy);
+
+        // Adjust the selected block's size to match the request
+        blk->end = blk->start + blocksize - 1;
+    }
+
+    // Assign the block to the process and add it to the allocated list
+    blk->pid = pid;
+    list_add_ascending_by_address(alloclist, blk);
+    return blocksize;
+}
+
+// Returns the size of the released block, or 0 if the pid owns no memory
+int deallocate_memory(list_t * alloclist, list_t * freelist, int pid, int policy) { 
+     /* if policy == 1 -> FIFO
+     *              2 -> BESTFIT 
+     *              3 -> WORSTFIT
+     * 
+     * pid - process id of the block to deallocate 
+     * alloclist - list of allocated memory blocksize
+     * freelist - list of free memory blocks
+     * 
+     * 
+    * 1. Check if a node is in the ALLOC_LIST with a blk.pid = pid
+    * 2. if so, remove it and go to #3, if not return 0
+    * 3. set the blk.pid back to 0
+    * 4. add the blk back to the FREE_LIST based on policy.
+    */
+    block_t *blk;
+    int size;
+
+    // Check if the process exists in the allocated list
+    blk = list_get_by_pid(alloclist, pid);
+    if (blk == NULL) {
+        return 0;
+    }
+
+    // Remove the block from the allocated list
+    list_unlink(alloclist, blk);
+
+    // Reset the block's PID to 0
+    blk->pid = 0;
+    size = blk->end - blk->start + 1;
+
+    // Add the block back to the free list based on the policy
+    free_list_insert(freelist, blk, policy);
+    return size;
+}
+
+// Sorts the free list by address and merges adjacent free blocks
+list_t* coalese_memory(list_t *list) {
+    list_t *temp_list = list_alloc();
+
+    // Sort the free list by address
+    list_sort_by_address(list);
+    list_splice(temp_list, list);
+
+    // Merge adjacent blocks
+    list_coalese_nodes(temp_list);
+
+    return temp_list;
+}
+
+// Returns 1 if all free memory is a single extent at the top of the partition
+static int memory_is_compact(list_t *freelist, int partition_size) {
+    return freelist->length == 0 ||
+           (freelist->length == 1 && freelist->head->blk->end == partition_size - 1);
+}
+
+// Replaces the free blocks inside [lo, hi] with the single free extent [start, hi]
+static void free_list_replace_range(list_t *freelist, int lo, int hi, int start, int policy) {
+    node_t *current = freelist->head;
+    node_t *next;
+    block_t *blk;
+
+    while (current != NULL) {
+        next = current->next;
+        if (current->blk->start >= lo && current->blk->end <= hi)
+            block_free(list_unlink(freelist, current->blk));
+        current = next;
+    }
+    if (start <= hi) {
+        blk = block_alloc();
+        blk->start = start;
+        blk->end = hi;
+        free_list_insert(freelist, blk, policy);
+    }
+}
+
+// Slides allocated blocks toward address 0, resuming where the last bounded pass stopped
+long compact_memory(list_t *alloclist, list_t *freelist, int partition_size,
+                    long budget, int policy, compact_result_t *result) {
+    node_t *current;
+    block_t *blk;
+    int from_head, cursor, size;
+    int lo = -1, hi = -1;       // the moved blocks spanned [lo, hi] with their gaps
+    int rest = 0;               // first address past the last moved block
+    long moved = 0;
+
+    result->bytes_moved = 0;
+    result->relocations = 0;
+    result->done = 1;
+
+    if (memory_is_compact(freelist, partition_size)) {
+        alloclist->rover = NULL;
+        return 0;
+    }
+
+    // A bounded pass resumes at the alloc list's rover. Everything it moves
+    // goes right after the previous block, so gaps that open behind the rover
+    // are safe to leave for the next lap.
+    current = budget >= 0 && alloclist->rover != NULL ? alloclist->rover : alloclist->head;
+    from_head = current == alloclist->head;
+    cursor = current != NULL && current->prev != NULL ? current->prev->blk->end + 1 : 0;
+
+    // Allocated blocks are kept in address order, so one pass finds every gap
+    while (current != NULL) {
+        blk = current->blk;
+        size = blk->end - blk->start + 1;
+
+        if (blk->start > cursor) {
+            // A block larger than the whole budget is moved on its own so
+            // incremental compaction cannot stall behind it
+            if (budget >= 0 && (moved >= budget || (moved + size > budget && result->relocations > 0)))
+                break;
+            if (lo < 0)
+                lo = cursor;
+            hi = blk->end;
+            blk->start = cursor;
+            blk->end = cursor + size - 1;
+            rest = cursor + size;
+            moved += size;
+            result->relocations++;
+        }
+        cursor = blk->end + 1;
+        current = current->next;
+    }
+    alloclist->rover = current;
+    result->done = from_head && current == NULL;
+    result->bytes_moved = moved;
+
+    // The blocks moved within [lo, hi] are now contiguous from lo, so the free
+    // space there is one extent; only the free blocks in that range change.
+    // After a full pass everything above the last block is free as well.
+    if (result->done)
+        free_list_replace_range(freelist, lo >= 0 ? lo : cursor, partition_size - 1, cursor, policy);
+    else if (result->relocations > 0)
+        free_list_replace_range(freelist, lo, hi, rest, policy);
+
+    return moved;
+}
@@ -0,0 +1,97 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include "list.h"
+
+/**
+ * Contiguous allocation policies for the MMU simulator
+ */
+
+#define POLICY_FIRST_FIT 1
+#define POLICY_BEST_FIT 2
+#define POLICY_WORST_FIT 3
+#define POLICY_NEXT_FIT 4
+#define POLICY_HUGE_PAGE 5
+#define POLICY_COUNT 5
+
+/* Huge-page defaults: 2 MiB pages for requests of at least 1 MiB. */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define HUGE_PAGE_THRESHOLD (HUGE_PAGE_SIZE / 2)
+
+/* State and counters for the huge-page policy. The partition is viewed as
+ * huge_size-aligned regions, each either intact (huge-page pool) or broken
+ * (small-page pool). Small requests are served only from broken regions and
+ * the partial region at the top of the partition; an intact region is
+ * broken when the small-page pool has no room. Broken regions that are
+ * entirely free again are returned to the huge-page pool when a huge
+ * request does not fit. */
+typedef struct huge_page {
+  int huge_size;            // bytes per huge page
+  int threshold;            // requests of at least this size use huge pages
+  int nregions;             // whole huge regions in the partition
+  unsigned char *broken;    // per region, 1 while it is in the small-page pool
+  long huge_allocs;         // requests served from aligned huge regions
+  long small_allocs;        // requests served from the small-page pool
+  long long align_waste;    // bytes added by rounding huge requests up
+  long regions_broken;      // intact regions moved to the small-page pool
+  long regions_reclaimed;   // empty broken regions moved back
+} huge_page_t;
+
+/* Returns the report name of a policy ("FIRSTFIT", ...). */
+const char *policy_name(int policy);
+
+/* Carves blocksize bytes for pid out of the free list.
+ * Returns the size of the allocated block, or 0 if no free block is large
+ * enough.
+ * scanned (may be NULL) receives the number of free blocks examined.
+ * POLICY_HUGE_PAGE needs the caller's huge_page_t and is served by
+ * allocate_huge; allocate_memory fails it. */
+int allocate_memory(list_t *freelist, list_t *alloclist, int pid, int blocksize, int policy,
+                    int *scanned);
+
+/* Sets up huge-page state for a partition with every region intact.
+ * huge_size and threshold of 0 select the defaults. Returns 0 on success,
+ * -1 if the region table cannot be allocated. */
+int hugepage_init(huge_page_t *hp, int partition_size, int huge_size, int threshold);
+void hugepage_destroy(huge_page_t *hp);
+
+/* Huge-page aware allocation. Requests of at least hp->threshold bytes are
+ * rounded up to whole huge pages and placed on a huge_size boundary inside
+ * intact regions. Smaller requests are served from the small-page pool,
+ * breaking the intact regions under the lowest fit when the pool has no
+ * room. The free list is kept in address order and coalesced on free.
+ * Returns the allocated size or 0. */
+int allocate_huge(list_t *freelist, list_t *alloclist, int pid, int blocksize,
+                  huge_page_t *hp, int *scanned);
+
+/* Counts the free intact huge regions in an address-ordered free list. */
+long hugepage_free_regions(list_t *freelist, const huge_page_t *hp);
+
+/* Returns pid's block to the free list.
+ * Returns the size of the released block, or 0 if pid owns no memory. */
+int deallocate_memory(list_t *alloclist, list_t *freelist, int pid, int policy);
+
+/* Returns a new address-ordered list with adjacent free blocks merged;
+ * list is left empty. */
+list_t *coalese_memory(list_t *list);
+
+/* Outcome of one compaction pass. */
+typedef struct compact_result {
+  long bytes_moved;         // bytes copied by relocation
+  long relocations;         // blocks that were moved
+  int done;                 // 1 if memory is now fully compacted
+} compact_result_t;
+
+/* Slides allocated blocks toward address 0, in address order, and replaces
+ * the free blocks between the moved ones with the space left above them. A
+ * fully compacted partition has a single free block at the top, and calls on
+ * it return at once.
+ * budget limits the bytes moved in this pass (negative = unlimited); a block
+ * larger than the budget is still moved when it is the first move of the
+ * pass. A bounded pass resumes at the alloc list's rover, where the previous
+ * one stopped, and wraps to the head after reaching the tail.
+ * Returns the bytes moved. */
+long compact_memory(list_t *alloclist, list_t *freelist, int partition_size,
+                    long budget, int policy, compact_result_t *result);
+
+#endif				// ALLOC_H
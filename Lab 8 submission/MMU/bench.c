@@ -0,0 +1,412 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "list.h"
+#include "util.h"
+#include "stats.h"
+#include "alloc.h"
+#include "bitmap.h"
+
+/**
+ * Allocator benchmark driver.
+ *
+ * Replays every trace under every selected policy, plus the bitmap backend, and
+ * writes one CSV row per (trace, policy) pair followed by one ALL row per policy
+ * that merges its replays. Only the allocator calls are timed; trace parsing
+ * and free-list sampling happen outside the timed regions, and the cost of
+ * the clock reads around each timed call is measured once and subtracted.
+ *
+ * The (trace, policy) replays are independent, so they are handed out to a
+ * pool of worker threads. Each worker builds its own lists from its own
+ * thread-local node pools; rows are written in job order once all are done.
+ */
+
+#define BENCH_USAGE "usage: ./mmubench [-o <csv file>] [-j <workers>] [-p <policies>] " \
+    "<trace file> [trace file ...]\n" \
+    "  -j <workers>   replays to run at once (default: online CPUs)\n" \
+    "  -p <policies>  distinct letters from FBWNHM (M = bitmap backend), default all\n"
+
+// Operations per chunk and between fragmentation samples
+#define BENCH_CHUNK 4096
+#define BENCH_SAMPLE_INTERVAL 1024
+
+// Clock reads averaged to estimate the cost of one
+#define BENCH_CLOCK_CALIBRATE 100000
+
+// Pseudo-policy selecting the bitmap backend (first fit by address, 1-byte units)
+#define BENCH_BITMAP (POLICY_COUNT + 1)
+
+// Results of one replay
+typedef struct bench_result {
+    mmu_stats_t stats;
+    double alloc_ns;        // total time spent in allocate_memory
+    double free_ns;         // total time spent in deallocate_memory
+    double coalesce_ns;     // total time spent coalescing
+    int peak_free_blocks;   // longest free list seen after any operation
+    long long align_waste;  // huge-page rounding bytes (HUGEPAGE only)
+    long regions_broken;    // huge regions moved to the small-page pool (HUGEPAGE only)
+    double frag_final;      // external fragmentation at the end, summed when merged
+    int replays;            // traces folded into this result
+    int ok;                 // replay finished without a trace error
+} bench_result_t;
+
+// One (trace, policy) replay handed to a worker
+typedef struct bench_job {
+    const char *path;
+    int policy;
+    bench_result_t result;
+} bench_job_t;
+
+// Work queue shared by the workers
+typedef struct bench_queue {
+    pthread_mutex_t lock;
+    bench_job_t *jobs;
+    int njobs;
+    int next;               // first job not yet claimed
+} bench_queue_t;
+
+// Monotonic clock in nanoseconds
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Cost of one now_ns() call, set once by bench_calibrate before any replay
+static double clock_overhead_ns;
+
+// Measures the clock read overhead that every timed operation also pays
+static void bench_calibrate(void) {
+    double t0 = now_ns();
+    int i;
+
+    for (i = 0; i < BENCH_CLOCK_CALIBRATE; i++)
+        now_ns();
+    clock_overhead_ns = (now_ns() - t0) / (BENCH_CLOCK_CALIBRATE + 1);
+}
+
+// Removes the clock overhead of n timed operations from their total time
+static double bench_net_ns(double total_ns, long n) {
+    total_ns -= n * clock_overhead_ns;
+    return total_ns > 0 ? total_ns : 0.0;
+}
+
+// Replays one trace under one policy; returns 0 on success
+static int bench_replay(const char *path, int policy, bench_result_t *r) {
+    trace_t *trace;
+    int (*ops)[2];
+    list_t *freelist, *alloclist, *coalesced;
+    block_t *partition;
+    bitmap_mem_t bm;
+    huge_page_t hp;
+    FILE *f;
+    free_summary_t final;
+    int n, i, size, partition_size, scanned, status;
+    double t0;
+
+    f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Invalid filepath %s\n", path);
+        return -1;
+    }
+    trace = malloc(sizeof(*trace));
+    ops = malloc(BENCH_CHUNK * sizeof(*ops));
+    if (trace == NULL || ops == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    if (trace_open(trace, f, &partition_size) != 0) {
+        free(trace);
+        free(ops);
+        fclose(f);
+        return -1;
+    }
+
+    memset(r, 0, sizeof(*r));
+    stats_init(&r->stats, partition_size);
+
+    freelist = list_alloc();
+    alloclist = list_alloc();
+    partition = block_alloc();
+    partition->start = 0;
+    partition->end = partition_size - 1;
+    list_add_to_front(freelist, partition);
+
+    if (policy == BENCH_BITMAP) {
+        if (bitmap_init(&bm, partition_size, 1) != 0) {
+            fprintf(stderr, "Error: cannot allocate bitmap\n");
+            exit(1);
+        }
+        r->stats.scan_unit = "words";
+    }
+    if (policy == POLICY_HUGE_PAGE && hugepage_init(&hp, partition_size, 0, 0) != 0) {
+        fprintf(stderr, "Error: cannot allocate huge-page regions\n");
+        exit(1);
+    }
+
+    while ((n = trace_next_chunk(trace, ops, BENCH_CHUNK)) > 0) {
+        for (i = 0; i < n; i++) {
+            if (ops[i][0] != -99999 && ops[i][0] > 0) {
+                t0 = now_ns();
+                if (policy == BENCH_BITMAP)
+                    size = bitmap_allocate(&bm, alloclist, ops[i][0], ops[i][1], &scanned);
+                else if (policy == POLICY_HUGE_PAGE)
+                    size = allocate_huge(freelist, alloclist, ops[i][0], ops[i][1], &hp, &scanned);
+                else
+                    size = allocate_memory(freelist, alloclist, ops[i][0], ops[i][1], policy, &scanned);
+                r->alloc_ns += now_ns() - t0;
+                stats_record_scan(&r->stats, scanned);
+                stats_record_alloc(&r->stats, size > 0, size);
+            } else if (ops[i][0] != -99999 && ops[i][0] < 0) {
+                t0 = now_ns();
+                if (policy == BENCH_BITMAP)
+                    size = bitmap_deallocate(&bm, alloclist, -ops[i][0]);
+                else
+                    size = deallocate_memory(alloclist, freelist, -ops[i][0], policy);
+                r->free_ns += now_ns() - t0;
+                stats_record_dealloc(&r->stats, size);
+            } else if (policy == BENCH_BITMAP) {
+                stats_record_coalesce(&r->stats); // The bitmap is always coalesced
+            } else {
+                t0 = now_ns();
+                coalesced = coalese_memory(freelist);
+                list_free(freelist);
+                freelist = coalesced;
+                r->coalesce_ns += now_ns() - t0;
+                stats_record_coalesce(&r->stats);
+            }
+
+            if (list_length(freelist) > r->peak_free_blocks)
+                r->peak_free_blocks = list_length(freelist);
+            if (r->stats.ops % BENCH_SAMPLE_INTERVAL == 0) {
+                // The bitmap's free runs are only counted when sampled
+                if (policy == BENCH_BITMAP)
+                    bitmap_free_list(&bm, freelist);
+                stats_sample(&r->stats, freelist);
+            }
+        }
+    }
+
+    if (policy == BENCH_BITMAP) {
+        bitmap_free_list(&bm, freelist);
+        bitmap_destroy(&bm);
+    }
+    if (policy == POLICY_HUGE_PAGE) {
+        r->align_waste = hp.align_waste;
+        r->regions_broken = hp.regions_broken;
+        hugepage_destroy(&hp);
+    }
+    stats_sample(&r->stats, freelist);
+    if (r->stats.free_blocks_peak > r->peak_free_blocks)
+        r->peak_free_blocks = r->stats.free_blocks_peak;
+    free_list_summary(freelist, &final);
+    r->frag_final = external_fragmentation(&final);
+    r->replays = 1;
+    r->alloc_ns = bench_net_ns(r->alloc_ns, r->stats.alloc_ok + r->stats.alloc_fail);
+    r->free_ns = bench_net_ns(r->free_ns, r->stats.dealloc_ok + r->stats.dealloc_fail);
+    if (policy != BENCH_BITMAP)
+        r->coalesce_ns = bench_net_ns(r->coalesce_ns, r->stats.coalesces);
+
+    status = trace->error ? -1 : 0;
+    fclose(f);
+    free(trace);
+    free(ops);
+    list_free(freelist);
+    list_free(alloclist);
+    list_pool_reset();
+    return status;
+}
+
+// Folds one finished replay into a per-policy total
+static void bench_merge(bench_result_t *dst, const bench_result_t *src) {
+    if (dst->replays == 0)
+        stats_init(&dst->stats, 0);
+    stats_merge(&dst->stats, &src->stats);
+    dst->alloc_ns += src->alloc_ns;
+    dst->free_ns += src->free_ns;
+    dst->coalesce_ns += src->coalesce_ns;
+    if (src->peak_free_blocks > dst->peak_free_blocks)
+        dst->peak_free_blocks = src->peak_free_blocks;
+    dst->frag_final += src->frag_final;
+    dst->align_waste += src->align_waste;
+    dst->regions_broken += src->regions_broken;
+    dst->replays += src->replays;
+}
+
+// Worker loop: claims jobs until the queue is drained
+static void *bench_worker(void *arg) {
+    bench_queue_t *q = arg;
+    bench_job_t *job;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        job = q->next < q->njobs ? &q->jobs[q->next++] : NULL;
+        pthread_mutex_unlock(&q->lock);
+        if (job == NULL)
+            break;
+
+        job->result.ok = bench_replay(job->path, job->policy, &job->result) == 0;
+        if (job->result.ok)
+            fprintf(stderr, "%s %s: %ld ops\n", job->path,
+                    job->policy == BENCH_BITMAP ? "BITMAP" : policy_name(job->policy),
+                    job->result.stats.ops);
+    }
+    return NULL;
+}
+
+// Writes one CSV row for a finished replay
+static void bench_report(FILE *out, const char *path, int policy, const bench_result_t *r) {
+    const mmu_stats_t *s = &r->stats;
+    long allocs = s->alloc_ok + s->alloc_fail;
+    long frees = s->dealloc_ok + s->dealloc_fail;
+    double total_ns = r->alloc_ns + r->free_ns + r->coalesce_ns;
+
+    fprintf(out, "%s,%s,%ld,%ld,%ld,%.1f,%.1f,%.1f,%d,%.4f,%.4f,%.4f,%.2f,%d,%d,%d,%s,%lld,%ld\n",
+            path, policy == BENCH_BITMAP ? "BITMAP" : policy_name(policy), s->ops, allocs, frees,
+            total_ns > 0 ? s->ops / (total_ns / 1e9) : 0.0,
+            allocs > 0 ? r->alloc_ns / allocs : 0.0,
+            frees > 0 ? r->free_ns / frees : 0.0,
+            r->peak_free_blocks,
+            s->samples > 0 ? s->frag_sum / s->samples : 0.0,
+            r->replays > 0 ? r->frag_final / r->replays : 0.0,
+            allocs > 0 ? (double)s->alloc_fail / allocs : 0.0,
+            s->scan_count > 0 ? (double)s->scan_total / s->scan_count : 0.0,
+            stats_scan_quantile(s, 0.50), stats_scan_quantile(s, 0.99), s->scan_max,
+            s->scan_unit, r->align_waste, r->regions_broken);
+}
+
+// Maps a policy letter from -p to a policy number, or 0
+static int bench_policy(char c) {
+    switch (c) {
+    case 'F': return POLICY_FIRST_FIT;
+    case 'B': return POLICY_BEST_FIT;
+    case 'W': return POLICY_WORST_FIT;
+    case 'N': return POLICY_NEXT_FIT;
+    case 'H': return POLICY_HUGE_PAGE;
+    case 'M': return BENCH_BITMAP;
+    default:  return 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    FILE *out = stdout;
+    bench_queue_t queue;
+    bench_result_t totals[BENCH_BITMAP + 1];
+    pthread_t *threads;
+    int policies[BENCH_BITMAP];
+    int npolicies = 0, nworkers = 0, first = 1, i, j, k, status = 0;
+    const char *p;
+    long ops = 0;
+    double t0, wall;
+
+    while (first + 1 < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-o") == 0) {
+            out = fopen(argv[first + 1], "w");
+            if (!out) {
+                fprintf(stderr, "Error: cannot open %s\n", argv[first + 1]);
+                exit(1);
+            }
+        } else if (strcmp(argv[first], "-j") == 0) {
+            nworkers = atoi(argv[first + 1]);
+            if (nworkers <= 0) {
+                printf(BENCH_USAGE);
+                exit(1);
+            }
+        } else if (strcmp(argv[first], "-p") == 0) {
+            // Each policy at most once, or the ALL rows would count it twice
+            for (p = argv[first + 1]; *p != '\0'; p++) {
+                j = bench_policy(*p);
+                for (k = 0; k < npolicies && policies[k] != j; k++)
+                    ;
+                if (j == 0 || k < npolicies) {
+                    printf(BENCH_USAGE);
+                    exit(1);
+                }
+                policies[npolicies++] = j;
+            }
+        } else {
+            break;
+        }
+        first += 2;
+    }
+    if (first >= argc) {
+        printf(BENCH_USAGE);
+        exit(1);
+    }
+    if (npolicies == 0) {
+        for (j = 1; j <= BENCH_BITMAP; j++)
+            policies[npolicies++] = j;
+    }
+    if (nworkers == 0) {
+        nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (nworkers <= 0)
+            nworkers = 1;
+    }
+
+    // One job per (trace, policy) pair, trace-major like the report
+    queue.njobs = (argc - first) * npolicies;
+    queue.jobs = calloc(queue.njobs, sizeof(bench_job_t));
+    if (nworkers > queue.njobs)
+        nworkers = queue.njobs;
+    threads = malloc(nworkers * sizeof(pthread_t));
+    if (queue.jobs == NULL || threads == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    for (i = first; i < argc; i++) {
+        for (j = 0; j < npolicies; j++) {
+            queue.jobs[(i - first) * npolicies + j].path = argv[i];
+            queue.jobs[(i - first) * npolicies + j].policy = policies[j];
+        }
+    }
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    bench_calibrate();
+    t0 = now_ns();
+    for (i = 0; i < nworkers; i++) {
+        if (pthread_create(&threads[i], NULL, bench_worker, &queue) != 0) {
+            fprintf(stderr, "Error: cannot start worker %d\n", i);
+            exit(1);
+        }
+    }
+    for (i = 0; i < nworkers; i++)
+        pthread_join(threads[i], NULL);
+    wall = now_ns() - t0;
+    pthread_mutex_destroy(&queue.lock);
+
+    fprintf(out, "trace,policy,ops,allocs,frees,ops_per_sec,ns_per_alloc,ns_per_free,"
+                 "peak_free_blocks,ext_frag_mean,ext_frag_final,alloc_fail_rate,"
+                 "scan_mean,scan_p50,scan_p99,scan_max,scan_unit,align_waste,regions_broken\n");
+
+    memset(totals, 0, sizeof(totals));
+    for (i = 0; i < queue.njobs; i++) {
+        bench_job_t *job = &queue.jobs[i];
+
+        if (!job->result.ok) {
+            status = 1;
+            continue;
+        }
+        bench_report(out, job->path, job->policy, &job->result);
+        bench_merge(&totals[job->policy], &job->result);
+        ops += job->result.stats.ops;
+    }
+    for (j = 0; j < npolicies; j++) {
+        if (totals[policies[j]].replays > 0)
+            bench_report(out, "ALL", policies[j], &totals[policies[j]]);
+    }
+    fprintf(stderr, "%d replays on %d workers in %.2f s (%.0f ops/s)\n",
+            queue.njobs, nworkers, wall / 1e9, wall > 0 ? ops / (wall / 1e9) : 0.0);
+
+    free(queue.jobs);
+    free(threads);
+    if (out != stdout)
+        fclose(out);
+    return status;
+}
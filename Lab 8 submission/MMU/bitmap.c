@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitmap.h"
+
+#define WORD_BITS 64
+#define ALL_ONES (~(uint64_t)0)
+
+// Words tested per step when skipping fully used or fully free stretches
+#define SKIP_WORDS 8
+
+// GCC generic vector of two words, lowered to whatever SIMD the build target
+// has; may_alias lets it be loaded through the uint64_t map
+typedef uint64_t vword __attribute__((vector_size(16), aligned(8), may_alias));
+
+// AND of the SKIP_WORDS words at w: three vector ANDs, then one lane pair
+static uint64_t and_words(const uint64_t *w) {
+    const vword *v = (const vword *)w;
+    vword acc = (v[0] & v[1]) & (v[2] & v[3]);
+
+    return acc[0] & acc[1];
+}
+
+// OR of the SKIP_WORDS words at w
+static uint64_t or_words(const uint64_t *w) {
+    const vword *v = (const vword *)w;
+    vword acc = (v[0] | v[1]) | (v[2] | v[3]);
+
+    return acc[0] | acc[1];
+}
+
+// Mask of bits [lo, hi) within one word, 0 <= lo < hi <= 64
+static uint64_t range_mask(int lo, int hi) {
+    uint64_t upper = hi == WORD_BITS ? ALL_ONES : (((uint64_t)1 << hi) - 1);
+    return upper & (ALL_ONES << lo);
+}
+
+int bitmap_init(bitmap_mem_t *bm, int partition_size, int unit) {
+    if (unit < 1)
+        unit = 1;
+
+    bm->unit = unit;
+    bm->nunits = partition_size / unit;
+    bm->nwords = (bm->nunits + WORD_BITS - 1) / WORD_BITS;
+    bm->words = malloc(sizeof(uint64_t) * (bm->nwords > 0 ? bm->nwords : 1));
+    if (bm->words == NULL)
+        return -1;
+
+    bitmap_reset(bm);
+    return 0;
+}
+
+void bitmap_destroy(bitmap_mem_t *bm) {
+    free(bm->words);
+    bm->words = NULL;
+}
+
+void bitmap_reset(bitmap_mem_t *bm) {
+    int tail = bm->nunits % WORD_BITS;
+
+    memset(bm->words, 0, sizeof(uint64_t) * bm->nwords);
+    // Units past the partition are permanently "allocated" so scans stop there
+    if (tail != 0)
+        bm->words[bm->nwords - 1] = range_mask(tail, WORD_BITS);
+    bm->hint = 0;
+    bm->scanned = 0;
+}
+
+// First clear bit at or after pos, or nunits if there is none
+static int next_zero(bitmap_mem_t *bm, int pos) {
+    const uint64_t *w = bm->words;
+    int i = pos / WORD_BITS;
+    uint64_t bits;
+
+    if (i >= bm->nwords)
+        return bm->nunits;
+
+    bits = ~w[i] & (ALL_ONES << (pos % WORD_BITS));
+    bm->scanned++;
+    while (bits == 0) {
+        i++;
+        // Skip fully allocated stretches SKIP_WORDS words at a time
+        while (i + SKIP_WORDS <= bm->nwords && and_words(w + i) == ALL_ONES) {
+            i += SKIP_WORDS;
+            bm->scanned += SKIP_WORDS;
+        }
+        if (i >= bm->nwords)
+            return bm->nunits;
+        bits = ~w[i];
+        bm->scanned++;
+    }
+    return i * WORD_BITS + __builtin_ctzll(bits);
+}
+
+// First set bit in [pos, limit), or limit if the whole range is clear
+static int next_one(bitmap_mem_t *bm, int pos, int limit) {
+    const uint64_t *w = bm->words;
+    int i = pos / WORD_BITS;
+    int last = (limit - 1) / WORD_BITS;
+    uint64_t bits;
+    int found;
+
+    bits = w[i] & (ALL_ONES << (pos % WORD_BITS));
+    bm->scanned++;
+    while (bits == 0) {
+        i++;
+        // Skip fully free stretches SKIP_WORDS words at a time
+        while (i + SKIP_WORDS <= last && or_words(w + i) == 0) {
+            i += SKIP_WORDS;
+            bm->scanned += SKIP_WORDS;
+        }
+        if (i > last)
+            return limit;
+        bits = w[i];
+        bm->scanned++;
+    }
+
+    found = i * WORD_BITS + __builtin_ctzll(bits);
+    return found < limit ? found : limit;
+}
+
+int bitmap_find_run(bitmap_mem_t *bm, int need) {
+    int pos = bm->hint * WORD_BITS;
+    int start, stop;
+
+    bm->scanned = 0;
+    if (need <= 0 || need > bm->nunits)
+        return -1;
+
+    while (1) {
+        start = next_zero(bm, pos);
+        if (start >= bm->nunits || start > bm->nunits - need)
+            return -1;
+        stop = next_one(bm, start, start + need);
+        if (stop - start >= need)
+            return start;
+        pos = stop;
+    }
+}
+
+// Sets or clears a range of bits; returns how many were already in that state
+static int set_range(bitmap_mem_t *bm, int first, int count, int value) {
+    int i = first / WORD_BITS;
+    int lo = first % WORD_BITS;
+    int remaining = count;
+    int already = 0;
+    int hi;
+    uint64_t mask;
+
+    while (remaining > 0) {
+        hi = lo + remaining < WORD_BITS ? lo + remaining : WORD_BITS;
+        mask = range_mask(lo, hi);
+        if (value) {
+            already += __builtin_popcountll(bm->words[i] & mask);
+            bm->words[i] |= mask;
+        } else {
+            already += __builtin_popcountll(~bm->words[i] & mask);
+            bm->words[i] &= ~mask;
+        }
+        remaining -= hi - lo;
+        lo = 0;
+        i++;
+    }
+    return already;
+}
+
+int bitmap_mark(bitmap_mem_t *bm, int first, int count) {
+    int already = set_range(bm, first, count, 1);
+
+    // Advance the hint past any words that just became full
+    while (bm->hint < bm->nwords && bm->words[bm->hint] == ALL_ONES)
+        bm->hint++;
+    return already;
+}
+
+int bitmap_clear(bitmap_mem_t *bm, int first, int count) {
+    int already = set_range(bm, first, count, 0);
+
+    if (first / WORD_BITS < bm->hint)
+        bm->hint = first / WORD_BITS;
+    return already;
+}
+
+int bitmap_allocate(bitmap_mem_t *bm, list_t *alloclist, int pid, int blocksize, int *scanned) {
+    int need = (blocksize + bm->unit - 1) / bm->unit;
+    int first = bitmap_find_run(bm, need);
+    block_t *blk;
+
+    if (scanned != NULL)
+        *scanned = (int)bm->scanned;
+    if (first < 0)
+        return 0;
+
+    bitmap_mark(bm, first, need);
+
+    blk = block_alloc();
+    blk->pid = pid;
+    blk->start = first * bm->unit;
+    blk->end = (first + need) * bm->unit - 1;
+    list_add_ascending_by_address(alloclist, blk);
+    return blk->end - blk->start + 1;
+}
+
+int bitmap_deallocate(bitmap_mem_t *bm, list_t *alloclist, int pid) {
+    block_t *blk = list_get_by_pid(alloclist, pid);
+    int size;
+
+    if (blk == NULL)
+        return 0;
+
+    list_unlink(alloclist, blk);
+    size = blk->end - blk->start + 1;
+    bitmap_clear(bm, blk->start / bm->unit, size / bm->unit);
+    block_free(blk);
+    return size;
+}
+
+void bitmap_free_list(bitmap_mem_t *bm, list_t *freelist) {
+    block_t *blk;
+    int start, stop;
+
+    while ((blk = list_remove_from_front(freelist)) != NULL)
+        block_free(blk);
+
+    start = next_zero(bm, 0);
+    while (start < bm->nunits) {
+        stop = next_one(bm, start, bm->nunits);
+        blk = block_alloc();
+        blk->start = start * bm->unit;
+        blk->end = stop * bm->unit - 1;
+        list_add_to_back(freelist, blk);
+        start = stop < bm->nunits ? next_zero(bm, stop) : bm->nunits;
+    }
+}
+
+// Marks every block of a list, reporting blocks that overlap something already marked
+static int verify_list(bitmap_mem_t *bm, list_t *list, const char *name) {
+    node_t *current = list->head;
+    block_t *b;
+    int problems = 0;
+
+    for (; current != NULL; current = current->next) {
+        b = current->blk;
+        if (b->start < 0 || b->end < b->start || b->end >= bm->nunits) {
+            fprintf(stderr, "verify: %s block %d-%d is outside the partition\n", name, b->start, b->end);
+            problems++;
+        } else if (bitmap_mark(bm, b->start, b->end - b->start + 1) != 0) {
+            fprintf(stderr, "verify: %s block %d-%d (pid %d) overlaps another block\n",
+                    name, b->start, b->end, b->pid);
+            problems++;
+        }
+    }
+    return problems;
+}
+
+int bitmap_verify(bitmap_mem_t *bm, list_t *freelist, list_t *alloclist) {
+    int problems = 0;
+    int hole;
+
+    bitmap_reset(bm);
+    problems += verify_list(bm, alloclist, "allocated");
+    problems += verify_list(bm, freelist, "free");
+
+    // Every unit must now be covered by some block
+    hole = next_zero(bm, 0);
+    if (hole < bm->nunits) {
+        fprintf(stderr, "verify: memory at %d is neither free nor allocated\n", hole);
+        problems++;
+    }
+    return problems;
+}
@@ -0,0 +1,60 @@
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+#include "list.h"
+
+/**
+ * Bitmap model of the partition.
+ *
+ * The partition is divided into fixed-size units, one bit per unit
+ * (1 = allocated). Free runs are found 64 units at a time with
+ * count-trailing-zeros, and fully used or fully free stretches are skipped
+ * eight words at a time with GCC vector ANDs/ORs. Allocated blocks are still kept in an
+ * address-ordered list_t so the usual printing and pid lookups work.
+ */
+
+typedef struct bitmap_mem {
+  int unit;                 // bytes per unit
+  int nunits;               // usable units; bits past nunits stay set
+  int nwords;               // 64-bit words in the map
+  int hint;                 // no word before this one has a free unit
+  long scanned;             // words examined by the last search
+  uint64_t *words;
+} bitmap_mem_t;
+
+/* Models partition_size bytes with the given unit size.
+ * Returns 0 on success, -1 if memory cannot be allocated. */
+int bitmap_init(bitmap_mem_t *bm, int partition_size, int unit);
+void bitmap_destroy(bitmap_mem_t *bm);
+
+/* Marks every unit free again. */
+void bitmap_reset(bitmap_mem_t *bm);
+
+/* Returns the first unit of the lowest run of need free units, or -1. */
+int bitmap_find_run(bitmap_mem_t *bm, int need);
+
+/* Sets / clears count units starting at first. Both return how many of
+ * those units were already in the target state (0 when consistent). */
+int bitmap_mark(bitmap_mem_t *bm, int first, int count);
+int bitmap_clear(bitmap_mem_t *bm, int first, int count);
+
+/* First-fit allocation by address, rounded up to whole units. The block
+ * is added to alloclist. Returns its size, or 0 on failure; scanned (may
+ * be NULL) receives the number of bitmap words examined. */
+int bitmap_allocate(bitmap_mem_t *bm, list_t *alloclist, int pid, int blocksize, int *scanned);
+
+/* Releases pid's block. Returns its size, or 0 if pid owns no memory. */
+int bitmap_deallocate(bitmap_mem_t *bm, list_t *alloclist, int pid);
+
+/* Replaces the contents of freelist with the bitmap's free runs, in
+ * address order (already coalesced). */
+void bitmap_free_list(bitmap_mem_t *bm, list_t *freelist);
+
+/* Cross-checks a list backend: every unit must be covered by exactly one
+ * block of freelist or alloclist. Prints each problem found to stderr and
+ * returns the number of problems (0 when the lists are consistent).
+ * The map's contents are overwritten; use a bitmap with a 1-byte unit. */
+int bitmap_verify(bitmap_mem_t *bm, list_t *freelist, list_t *alloclist);
+
+#endif				// BITMAP_H
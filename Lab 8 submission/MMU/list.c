@@ -2,32 +2,144 @@
 #include <stdlib.h>
 #include <string.h>
 #include "list.h"
+#include "pool.h"
+
+// Nodes and blocks are recycled through slab pools instead of malloc/free.
+// The pools are per thread, so lists may be used concurrently as long as each
+// list stays on the thread that built it.
+#define LIST_POOL_SLAB 1024
+
+static __thread pool_t node_pool;
+static __thread pool_t block_pool;
+static __thread bool pools_ready = false;
+
+// Lazily sets up the node and block pools on first use
+static void list_pools_init(void) {
+    if (!pools_ready) {
+        pool_init(&node_pool, sizeof(node_t), LIST_POOL_SLAB);
+        pool_init(&block_pool, sizeof(block_t), LIST_POOL_SLAB);
+        pools_ready = true;
+    }
+}
+
+// Allocates a zeroed block from the block pool
+block_t *block_alloc() {
+    block_t *blk;
+
+    list_pools_init();
+    blk = pool_get(&block_pool);
+    blk->pid = 0;
+    blk->start = 0;
+    blk->end = 0;
+    blk->node = NULL;
+    return blk;
+}
+
+// Returns a block to the block pool
+void block_free(block_t *blk) {
+    pool_put(&block_pool, blk);
+}
+
+// Invalidates every node and block at once and releases the pool slabs
+void list_pool_reset() {
+    if (pools_ready) {
+        pool_destroy(&node_pool);
+        pool_destroy(&block_pool);
+    }
+}
 
 // Allocates and initializes an empty linked list
 list_t *list_alloc() { 
     list_t* list = (list_t*)malloc(sizeof(list_t));
     list->head = NULL;
+    list->tail = NULL;
+    list->length = 0;
+    list->rover = NULL;
     return list; 
 }
 
 // Allocates and initializes a new node with the given block
 node_t *node_alloc(block_t *blk) {   
-    node_t* node = malloc(sizeof(node_t));
+    node_t* node;
+
+    list_pools_init();
+    node = pool_get(&node_pool);
     node->next = NULL;
+    node->prev = NULL;
     node->blk = blk;
     return node; 
 }
 
-// Frees the memory allocated for a linked list
+// Frees a linked list along with every node and the blocks they hold
 void list_free(list_t *l) {
+    node_t *current;
+    node_t *next;
+
+    if (l == NULL) {
+        return;
+    }
+
+    current = l->head;
+    while (current != NULL) {
+        next = current->next;
+        block_free(current->blk);
+        node_free(current);
+        current = next;
+    }
     free(l);
-    return;
 }
 
-// Frees the memory allocated for a node
+// Returns a node to the node pool
 void node_free(node_t *node) {
-    free(node);
-    return;
+    pool_put(&node_pool, node);
+}
+
+// Moves the rover off a node that is about to be unlinked
+static void list_release_rover(list_t *l, node_t *node, node_t *replacement) {
+    if (l->rover == node)
+        l->rover = replacement;
+}
+
+// Links a new node for blk after prev, or at the front if prev is NULL
+static void list_link_after(list_t *l, node_t *prev, block_t *blk) {
+    node_t *node = node_alloc(blk);
+
+    node->prev = prev;
+    node->next = prev != NULL ? prev->next : l->head;
+    if (node->next != NULL)
+        node->next->prev = node;
+    else
+        l->tail = node;
+    if (prev != NULL)
+        prev->next = node;
+    else
+        l->head = node;
+    blk->node = node;
+    l->length++;
+}
+
+// Unlinks and frees node in O(1), returning its block; the rover moves to replacement
+static block_t *list_unlink_node(list_t *l, node_t *node, node_t *replacement) {
+    block_t *blk = node->blk;
+
+    if (node->prev != NULL)
+        node->prev->next = node->next;
+    else
+        l->head = node->next;
+    if (node->next != NULL)
+        node->next->prev = node->prev;
+    else
+        l->tail = node->prev;
+    l->length--;
+    list_release_rover(l, node, replacement);
+    blk->node = NULL;
+    node_free(node);
+    return blk;
+}
+
+// Removes a block from the list through its node handle
+block_t* list_unlink(list_t *l, block_t *blk) {
+    return list_unlink_node(l, blk->node, blk->node->next);
 }
 
 // Prints the contents of the list
@@ -47,153 +159,148 @@ void list_print(list_t *l) {
 
 // Returns the number of nodes in the list
 int list_length(list_t *l) { 
-    node_t *current = l->head;
-    int i = 0;
-    while (current != NULL) {
-        i++;
-        current = current->next;
-    }
-    return i; 
+    return l->length; 
 }
 
 // Adds a block to the end of the list
 void list_add_to_back(list_t *l, block_t *blk) {  
-    node_t* newNode = node_alloc(blk);
-    newNode->next = NULL;
-    if (l->head == NULL) {
-        l->head = newNode;
-    } else {
-        node_t *current = l->head;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        current->next = newNode;
-    }
+    list_link_after(l, l->tail, blk);
 }
 
 // Adds a block to the front of the list
 void list_add_to_front(list_t *l, block_t *blk) {  
-    node_t* newNode = node_alloc(blk);
-    newNode->next = l->head;
-    l->head = newNode;
+    list_link_after(l, NULL, blk);
 }
 
 // Inserts a block at a specific index in the list
 void list_add_at_index(list_t *l, block_t *blk, int index) {
     int i = 0;
-    node_t *newNode = node_alloc(blk);
     node_t *current = l->head;
 
-    if (index == 0) {
-        newNode->next = l->head->next;
-        l->head = newNode;
+    if (index == 0 || l->head == NULL) {
+        list_link_after(l, NULL, blk);
     } else if (index > 0) {
-        while (i < index && current->next != NULL) {
+        while (i < index - 1 && current->next != NULL) {
             current = current->next;
             i++;
         }
-        newNode->next = current->next;
-        current->next = newNode;
+        list_link_after(l, current, blk);
     }
 }
 
 // Adds a block to the list in ascending order of start address
 void list_add_ascending_by_address(list_t *l, block_t *newblk) {
-    node_t *current;
-    node_t *prev;
-    node_t *newNode = node_alloc(newblk);
-
-    if (l->head == NULL) {
-        l->head = newNode;
-    } else {
-        prev = current = l->head;
-
-        if (newblk->start < current->blk->start) { // Add at the front
-            newNode->next = l->head;
-            l->head = newNode;
-            return;
-        }
-
-        while (current != NULL && newblk->start > current->blk->start) {
-            prev = current;
-            current = current->next;
-        }
+    node_t *current = l->head;
+    node_t *prev = NULL;
 
-        prev->next = newNode;
-        newNode->next = current;
+    while (current != NULL && newblk->start > current->blk->start) {
+        prev = current;
+        current = current->next;
     }
+    list_link_after(l, prev, newblk);
 }
 
 // Adds a block to the list in ascending order of block size
 void list_add_ascending_by_blocksize(list_t *l, block_t *newblk) {
-    node_t *current;
-    node_t *prev;
-    node_t *newNode = node_alloc(newblk);
+    node_t *current = l->head;
+    node_t *prev = NULL;
     int newblk_size = newblk->end - newblk->start + 1;
-    int curblk_size;
 
-    if (l->head == NULL) {
-        l->head = newNode;
-    } else {
-        prev = current = l->head;
-        curblk_size = current->blk->end - current->blk->start + 1;
-
-        if (newblk_size < curblk_size) { // Add at the front
-            newNode->next = l->head;
-            l->head = newNode;
-            return;
-        }
-
-        while (current != NULL && newblk_size >= (current->blk->end - current->blk->start + 1)) {
-            prev = current;
-            current = current->next;
-        }
-
-        prev->next = newNode;
-        newNode->next = current;
+    while (current != NULL && newblk_size >= (current->blk->end - current->blk->start + 1)) {
+        prev = current;
+        current = current->next;
     }
+    list_link_after(l, prev, newblk);
 }
 
 // Adds a block to the list in descending order of block size
 void list_add_descending_by_blocksize(list_t *l, block_t *blk) {
-    node_t *current;
-    node_t *prev;
-    node_t *newNode = node_alloc(blk);
+    node_t *current = l->head;
+    node_t *prev = NULL;
     int newblk_size = blk->end - blk->start;
     int curblk_size;
 
-    if (l->head == NULL) {
-        l->head = newNode;
-    } else {
-        prev = current = l->head;
+    if (current != NULL) {
         curblk_size = current->blk->end - current->blk->start + 1;
 
-        if (current->next == NULL) { // Only one node
-            if (newblk_size >= curblk_size) { // Add in front
-                newNode->next = l->head;
-                l->head = newNode;
-            } else { // Add behind
-                current->next = newNode;
-                newNode->next = NULL;
-            }
-        } else { // Two or more nodes
-            if (newblk_size >= curblk_size) { // Add in front
-                newNode->next = l->head;
-                l->head = newNode;
-            } else {
-                while (current != NULL && newblk_size <= curblk_size) {
-                    prev = current;
-                    current = current->next;
-
-                    if (current != NULL) { // Update size for next node
-                        curblk_size = current->blk->end - current->blk->start;
-                    }
+        if (newblk_size < curblk_size) { // Goes somewhere behind the head
+            while (current != NULL && newblk_size <= curblk_size) {
+                prev = current;
+                current = current->next;
+
+                if (current != NULL) { // Update size for next node
+                    curblk_size = current->blk->end - current->blk->start;
                 }
-                prev->next = newNode;
-                newNode->next = current;
             }
         }
     }
+    list_link_after(l, prev, blk);
+}
+
+// Merges two address-ordered chains linked through next
+static node_t *list_merge_by_address(node_t *a, node_t *b) {
+    node_t head;
+    node_t *tail = &head;
+
+    while (a != NULL && b != NULL) {
+        if (b->blk->start < a->blk->start) {
+            tail->next = b;
+            b = b->next;
+        } else {
+            tail->next = a;
+            a = a->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a != NULL ? a : b;
+    return head.next;
+}
+
+// Sorts the list by start address with a bottom-up merge sort, then restores prev and tail
+void list_sort_by_address(list_t *l) {
+    node_t *runs[32] = { NULL };   // runs[i] holds a sorted chain of 2^i nodes
+    node_t *current = l->head;
+    node_t *chain, *prev = NULL;
+    int i;
+
+    while (current != NULL) {
+        chain = current;
+        current = current->next;
+        chain->next = NULL;
+        for (i = 0; i < 31 && runs[i] != NULL; i++) {
+            chain = list_merge_by_address(runs[i], chain);
+            runs[i] = NULL;
+        }
+        runs[i] = list_merge_by_address(runs[i], chain);
+    }
+
+    chain = NULL;
+    for (i = 0; i < 32; i++)
+        chain = list_merge_by_address(runs[i], chain);
+
+    l->head = chain;
+    for (current = chain; current != NULL; current = current->next) {
+        current->prev = prev;
+        prev = current;
+    }
+    l->tail = prev;
+}
+
+// Moves all of src's nodes onto the back of dst
+void list_splice(list_t *dst, list_t *src) {
+    if (src->head == NULL)
+        return;
+    src->head->prev = dst->tail;
+    if (dst->tail != NULL)
+        dst->tail->next = src->head;
+    else
+        dst->head = src->head;
+    dst->tail = src->tail;
+    dst->length += src->length;
+    src->head = NULL;
+    src->tail = NULL;
+    src->length = 0;
+    src->rover = NULL;
 }
 
 // Combines adjacent memory blocks in the list
@@ -211,8 +318,7 @@ void list_coalese_nodes(list_t *l) {
     while (current != NULL) {
         if (prev->blk->end + 1 == current->blk->start) { // Adjacent blocks
             prev->blk->end = current->blk->end; // Merge blocks
-            prev->next = current->next; // Remove current node
-            node_free(current);
+            block_free(list_unlink_node(l, current, prev)); // Remove current node
             current = prev->next; // Move to next
         } else {
             prev = current;
@@ -222,26 +328,9 @@ void list_coalese_nodes(list_t *l) {
 }
 
 block_t* list_remove_from_back(list_t *l){
-  block_t *value = NULL;
-  node_t *current = l->head;
-
-  if(l->head != NULL){
-    
-    if(current->next == NULL) { // one node
-         l->head->next = NULL;
-         value = current->blk;
-         node_free(current);
-    }
-    else {
-         while (current->next->next != NULL){
-            current = current->next;
-         }
-         value = current->blk;
-         node_free(current->next);
-         current->next = NULL;
-    }
-  }
-  return value;
+  if(l->tail == NULL)
+    return NULL;
+  return list_unlink_node(l, l->tail, NULL);
 }
 
 block_t* list_get_from_front(list_t *l) {
@@ -258,53 +347,27 @@ block_t* list_get_from_front(list_t *l) {
 
 
 block_t* list_remove_from_front(list_t *l) { 
-  block_t *value = NULL;
   if(l->head == NULL){
-    return value;
-  }
-  else{
-    node_t *current = l->head;
-    value = current->blk;
-    l->head = l->head->next;
-    node_free(current);
+    return NULL;
   }
-  return value; 
+  return list_unlink_node(l, l->head, l->head->next);
 }
 
 block_t* list_remove_at_index(list_t *l, int index) { 
-  int i;
-  block_t* value = NULL;
-  
-  bool found = false;
-  
-  if(l->head == NULL){
-    return value;
+  int i = 0;
+  node_t *current = l->head;
+
+  if(index < 0){
+    return NULL;
   }
-  else if (index == 0){
-    return list_remove_from_front(l);
+  while(current != NULL && i < index){
+    current = current->next;
+    i++;
   }
-  else if (index > 0){
-    node_t *current = l->head;
-    node_t *prev = current;
-    
-    i = 0;
-    while(current != NULL && !found){
-      if(i == index)
-          found = true;
-      else {
-         prev = current;
-         current = current->next;
-         i++;
-      }
-    }
-    
-    if(found) {
-      value = current->blk; 
-      prev->next = current->next;
-      node_free(current);
-    }
+  if(current == NULL){
+    return NULL;
   }
-  return value; 
+  return list_unlink_node(l, current, current->next);
 }
 
 bool compareBlks(block_t* a, block_t *b) {
@@ -409,6 +472,18 @@ bool list_is_in_by_pid(list_t *l, int pid){
     return false;
 }
 
+/* Returns the first block owned by pid, or NULL. */
+block_t* list_get_by_pid(list_t *l, int pid){
+    node_t *current = l->head;
+    while(current != NULL) {
+        if(comparePid(pid, current->blk)) {
+            return current->blk;
+        }
+        current = current->next;
+    }
+    return NULL;
+}
+
 /* Returns the index at which the given block of Size or greater appears. */
 int list_get_index_of_by_Size(list_t *l, int Size){
  int i = 0;
@@ -4,26 +4,39 @@
 //
 // Caitlyn Lynch
 
+#ifndef LIST_H
+#define LIST_H
+
 #include <stdbool.h>
 
+struct node;
+
+/* A block belongs to at most one list at a time; node is its handle in that
+ * list (NULL while unlinked), which lets it be unlinked in O(1). */
 typedef struct block {
     int pid;   // pid
 	int start;
   int end;
+  struct node *node;
 }block_t;
 
 /* Defines the node structure. Each node contains its element, and points to the
- * next node in the list. The last element in the list should have NULL as its
- * next pointer. */
+ * next and previous nodes in the list. The first and last elements have NULL as
+ * their prev and next pointers. */
 typedef struct node {
   block_t *blk;
 	struct node *next;
+	struct node *prev;
 }node_t;
 
-/* Defines the list structure, which simply points to the first node in the
- * list. */
+/* Defines the list structure, which points to the first and last nodes in the
+ * list and keeps a running count of its nodes. The rover is moved off any node
+ * that is removed, so it always points into the list or is NULL. */
 struct list {
 	node_t *head;
+	node_t *tail;
+	int length;
+	node_t *rover;   /* roving cursor for next-fit scans, NULL = head */
 };
 typedef struct list list_t;
 
@@ -32,13 +45,22 @@ typedef struct list list_t;
  * this linked list library. */
 list_t *list_alloc();
 node_t *node_alloc(block_t *blk);
+block_t *block_alloc();
 
+/* list_free also releases the nodes and the blocks they hold. */
 void list_free(list_t *l);
+void node_free(node_t *node);
+void block_free(block_t *blk);
+
+/* Releases every node and block of the calling thread in one step. Any list
+ * still holding them must not be used afterwards. Each thread that uses
+ * lists should call this before it exits. */
+void list_pool_reset();
 
 /* Prints the list in some format. */
 void list_print(list_t *l);
 
-/* Returns the length of the list. */
+/* Returns the length of the list in O(1). */
 int list_length(list_t *l);
 
 /* Methods for adding to the list. */
@@ -54,6 +76,9 @@ block_t* list_remove_from_back(list_t *l);
 block_t* list_remove_from_front(list_t *l);
 block_t* list_remove_at_index(list_t *l, int index);
 
+/* Removes blk from l in O(1) using its node handle. blk must be in l. */
+block_t* list_unlink(list_t *l, block_t *blk);
+
 /* Checks to see if block of Size exists in the list. */
 bool list_is_in(list_t *l, block_t *blk);
 
@@ -63,6 +88,9 @@ bool list_is_in_by_size(list_t *l, int Size);
 /* Checks to see if pid of block exists in the list. */
 bool list_is_in_by_pid(list_t *l, int pid);
 
+/* Returns the first block owned by pid, or NULL. */
+block_t* list_get_by_pid(list_t *l, int pid);
+
 /* Returns the element at location index. */
 block_t* list_get_elem_at(list_t *l, int index);
 
@@ -81,5 +109,13 @@ block_t* list_get_from_front(list_t *l);
 /* compare if two blocks are equal */
 bool compareBlks(block_t* a, block_t *b);
 
+/* Sorts the list by start address in O(n log n), relinking the existing nodes. */
+void list_sort_by_address(list_t *l);
+
+/* Moves every node from src to the back of dst in O(1). src is left empty. */
+void list_splice(list_t *dst, list_t *src);
+
 /* join adjacent nodes who blocks are physically next to each other */
 void list_coalese_nodes(list_t *l);
+
+#endif				// LIST_H
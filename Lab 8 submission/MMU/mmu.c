@@ -4,6 +4,10 @@
 #include <string.h>
 #include "list.h"
 #include "util.h"
+#include "stats.h"
+#include "alloc.h"
+#include "bitmap.h"
+#include "paging.h"
 
 // Converts a string to uppercase for case-insensitive comparison
 void TOUPPER(char *arr) {
@@ -12,8 +16,103 @@ void TOUPPER(char *arr) {
     }
 }
 
-// Reads input data from the file and parses the allocation policy
-void get_input(char *args[], int input[][2], int *n, int *size, int *policy) {
+// Number of trace operations parsed and replayed per chunk
+#define MMU_CHUNK 4096
+
+// Operations between free-list samples in summary mode (unless -i is given)
+#define MMU_SAMPLE_INTERVAL 1024
+
+// Output buffer size for snapshot files
+#define MMU_SNAPSHOT_BUF (1 << 20)
+
+#define MMU_USAGE "usage: ./mmu <input file> -{F | B | W | N | H } [-q] [-i <ops>] [-s <ops> <file>] [-c | -C <bytes>] [-b <unit> | -x] [-h <size> <threshold>] \n" \
+    "(F=FIFO | B=BESTFIT | W=WORSTFIT | N=NEXTFIT | H=HUGEPAGE)\n" \
+    "  -q               print only summary statistics\n" \
+    "  -i <ops>         summary: print a utilization timeline row every <ops>\n" \
+    "  -s <ops> <file>  dump both lists to <file> every <ops> operations\n" \
+    "  -c               COALESCE/COMPACT relocates allocated blocks toward address 0 (not with -H)\n" \
+    "  -C <bytes>       compact incrementally, moving at most <bytes> per operation (not with -H)\n" \
+    "  -b <unit>        bitmap backend, -F only: first fit by address over <unit>-byte units\n" \
+    "  -x               cross-check the free and allocated lists against a bitmap\n" \
+    "  -h <size> <threshold>  huge page size, and smallest request placed on huge pages\n"
+
+// Output options selected on the command line
+typedef struct mmu_options {
+    int quiet;              // summary mode: no per-operation output
+    long interval;          // timeline/sample interval, 0 = default sampling
+    long snapshot_every;    // snapshot interval, 0 = no snapshots
+    char *snapshot_path;    // file receiving the snapshots
+    int compact;            // relocate blocks on COALESCE/COMPACT
+    long compact_budget;    // incremental relocation budget per op, 0 = off
+    int bitmap_unit;        // bitmap backend unit size, 0 = list backend
+    int verify;             // cross-check the lists after every operation
+    int huge_size;          // huge page size for -H, 0 = default
+    int huge_threshold;     // huge page threshold for -H, 0 = default
+} mmu_options_t;
+
+// Parses the optional flags that follow the policy argument
+void get_options(int argc, char *argv[], mmu_options_t *opts) {
+    int i;
+
+    opts->quiet = 0;
+    opts->interval = 0;
+    opts->snapshot_every = 0;
+    opts->snapshot_path = NULL;
+    opts->compact = 0;
+    opts->compact_budget = 0;
+    opts->bitmap_unit = 0;
+    opts->verify = 0;
+    opts->huge_size = 0;
+    opts->huge_threshold = 0;
+
+    for (i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            opts->quiet = 1;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            opts->interval = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 2 < argc) {
+            opts->snapshot_every = atol(argv[++i]);
+            opts->snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0) {
+            opts->compact = 1;
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            opts->compact_budget = atol(argv[++i]);
+            if (opts->compact_budget <= 0) {
+                printf(MMU_USAGE);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            opts->bitmap_unit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0) {
+            opts->verify = 1;
+        } else if (strcmp(argv[i], "-h") == 0 && i + 2 < argc) {
+            opts->huge_size = atoi(argv[++i]);
+            opts->huge_threshold = atoi(argv[++i]);
+            if (opts->huge_size <= 0 || opts->huge_threshold <= 0) {
+                printf(MMU_USAGE);
+                exit(1);
+            }
+        } else {
+            printf(MMU_USAGE);
+            exit(1);
+        }
+    }
+
+    // The bitmap backend has no relocation and is its own cross-check
+    if (opts->bitmap_unit != 0 &&
+        (opts->bitmap_unit < 0 || opts->compact || opts->compact_budget > 0 || opts->verify)) {
+        printf(MMU_USAGE);
+        exit(1);
+    }
+
+    if (opts->interval < 0 || opts->snapshot_every < 0) {
+        printf(MMU_USAGE);
+        exit(1);
+    }
+}
+
+// Opens the trace file, reads its header and parses the allocation policy
+FILE *get_input(char *args[], trace_t *trace, int *size, int *policy) {
     FILE *input_file = fopen(args[1], "r");
     if (!input_file) {
         fprintf(stderr, "Error: Invalid filepath\n");
@@ -21,227 +120,331 @@ void get_input(char *args[], int input[][2], int *n, int *size, int *policy) {
         exit(0);
     }
 
-    parse_file(input_file, input, n, size); // Parse input file
-    fclose(input_file);
+    if (trace_open(trace, input_file, size) != 0) { // Read partition size
+        fclose(input_file);
+        exit(1);
+    }
+    printf("PARTITION_SIZE = %d\n", *size);
 
     TOUPPER(args[2]); // Convert policy argument to uppercase
 
     // Determine the memory allocation policy based on the input flag
     if ((strcmp(args[2], "-F") == 0) || (strcmp(args[2], "-FIFO") == 0))
-        *policy = 1; // First Fit
+        *policy = POLICY_FIRST_FIT;
     else if ((strcmp(args[2], "-B") == 0) || (strcmp(args[2], "-BESTFIT") == 0))
-        *policy = 2; // Best Fit
+        *policy = POLICY_BEST_FIT;
     else if ((strcmp(args[2], "-W") == 0) || (strcmp(args[2], "-WORSTFIT") == 0))
-        *policy = 3; // Worst Fit
+        *policy = POLICY_WORST_FIT;
+    else if ((strcmp(args[2], "-N") == 0) || (strcmp(args[2], "-NEXTFIT") == 0))
+        *policy = POLICY_NEXT_FIT;
+    else if ((strcmp(args[2], "-H") == 0) || (strcmp(args[2], "-HUGEPAGE") == 0))
+        *policy = POLICY_HUGE_PAGE;
     else {
-        printf("usage: ./mmu <input file> -{F | B | W }  \n(F=FIFO | B=BESTFIT | W=WORSTFIT)\n");
+        printf(MMU_USAGE);
         exit(1);
     }
+
+    return input_file;
 }
 
-// Allocates memory to a process based on the specified policy
-void allocate_memory(list_t *freelist, list_t *alloclist, int pid, int blocksize, int policy) {
-    /* Steps:
-     * 1. Find a suitable block in the free list based on the allocation policy.
-     * 2. If found:
-     *      - Remove it from the free list.
-     *      - Assign it to the process with the given PID.
-     *      - Adjust the block size and handle fragmentation (if any).
-     *      - Add the allocated block to the allocated list.
-     * 3. If no suitable block is found, print an error.
-     */
-
-    node_t *current = freelist->head;
-    node_t *best = NULL;
+// Prints the contents of a list with a message header to the given stream
+void fprint_list(FILE *out, list_t *list, char *message) {
+    node_t *current = list->head;
     block_t *blk;
-    int best_size = -1;
-    int current_size;
-
-    // Traverse the free list to find the most suitable block based on the policy
-    while (current != NULL) {
-        current_size = current->blk->end - current->blk->start + 1;
-
-        if (current_size >= blocksize) {
-            switch (policy) {
-                case 1: // First Fit: Select the first block that fits
-                    best = current;
-                    goto found;
-                case 2: // Best Fit: Select the smallest block that fits
-                    if (best == NULL || current_size < best_size) {
-                        best = current;
-                        best_size = current_size;
-                    }
-                    break;
-                case 3: // Worst Fit: Select the largest block that fits
-                    if (best == NULL || current_size > best_size) {
-                        best = current;
-                        best_size = current_size;
-                    }
-                    break;
-            }
-        }
-        current = current->next;
-    }
-
-found:
-    if (best == NULL) {
-        // No suitable block found
-        printf("Error: Memory Allocation %d blocks\n", blocksize);
-        return;
-    }
+    int i = 0;
 
-    // Remove the selected block from the free list
-    blk = best->blk;
-    int index = list_get_index_of(freelist, blk);
-    blk = list_remove_at_index(freelist, index);
+    fprintf(out, "%s:\n", message);
 
-    // Handle leftover memory as a fragment if the block is larger than requested
-    if ((blk->end - blk->start + 1) > blocksize) {
-        block_t *fragment = malloc(sizeof(block_t));
-        fragment->start = blk->start + blocksize;
-        fragment->end = blk->end;
-        fragment->pid = 0; // Fragment belongs to no process
+    while (current != NULL) {
+        blk = current->blk;
+        fprintf(out, "Block %d:\t START: %d\t END: %d", i, blk->start, blk->end);
 
-        // Add the fragment back to the free list based on the policy
-        if (policy == 1) {
-            list_add_to_back(freelist, fragment);
-        } else if (policy == 2) {
-            list_add_ascending_by_blocksize(freelist, fragment);
-        } else {
-            list_add_descending_by_blocksize(freelist, fragment);
-        }
+        if (blk->pid != 0)
+            fprintf(out, "\t PID: %d\n", blk->pid);
+        else
+            fprintf(out, "\n");
 
-        // Adjust the selected block's size to match the request
-        blk->end = blk->start + blocksize - 1;
+        current = current->next;
+        i += 1;
     }
-
-    // Assign the block to the process and add it to the allocated list
-    blk->pid = pid;
-    list_add_ascending_by_address(alloclist, blk);
 }
 
-void deallocate_memory(list_t * alloclist, list_t * freelist, int pid, int policy) { 
-     /* if policy == 1 -> FIFO
-     *              2 -> BESTFIT 
-     *              3 -> WORSTFIT
-     * 
-     * pid - process id of the block to deallocate 
-     * alloclist - list of allocated memory blocksize
-     * freelist - list of free memory blocks
-     * 
-     * 
-    * 1. Check if a node is in the ALLOC_LIST with a blk.pid = pid
-    * 2. if so, remove it and go to #3, if not print "Error: Can't locate Memory Used by PID: <pid>"
-    * 3. set the blk.pid back to 0
-    * 4. add the blk back to the FREE_LIST based on policy.
-    */
-    block_t *blk;
-    int index;
+// Prints the contents of a list with a message header
+void print_list(list_t *list, char *message) {
+    fprint_list(stdout, list, message);
+}
 
-    // Check if the process exists in the allocated list
-    if (!list_is_in_by_pid(alloclist, pid)) {
-        printf("Error: Can't locate Memory Used by PID: %d\n", pid);
-        return;
+#define PAGING_USAGE "usage: ./mmu <reference trace> -P [-r FIFO | LRU | CLOCK | ARC] [-t <sets> <ways>] " \
+    "[-p <page shift>] [-q]\n" \
+    "  trace: number of frames, then one \"pid address\" pair per reference (pid < 2^24)\n" \
+    "  -r   page replacement policy (default LRU)\n" \
+    "  -t   TLB geometry, sets must be a power of two (default 64 x 4, 0 disables)\n" \
+    "  -p   log2 of the page size (default 12)\n" \
+    "  -q   print only summary statistics\n"
+
+// Replays a virtual-address trace through page tables, a TLB and page replacement
+int run_paging(int argc, char *argv[]) {
+    static trace_t trace;
+    static int pids[MMU_CHUNK];
+    static uint64_t addrs[MMU_CHUNK];
+    static const char *events[] = { "TLB HIT", "TLB MISS", "PAGE FAULT" };
+    paging_config_t cfg;
+    paging_t *pg;
+    FILE *input_file;
+    int nframes, quiet = 0, i, n, frame, event;
+
+    input_file = fopen(argv[1], "r");
+    if (!input_file) {
+        fprintf(stderr, "Error: Invalid filepath\n");
+        exit(0);
     }
-
-    // Remove the block from the allocated list
-    index = list_get_index_of_by_Pid(alloclist, pid);
-    blk = list_remove_at_index(alloclist, index);
-
-    // Reset the block's PID to 0
-    blk->pid = 0;
-
-    // Add the block back to the free list based on the policy
-    if (policy == 1) {
-        list_add_to_back(freelist, blk);
-    } else if (policy == 2) {
-        list_add_ascending_by_blocksize(freelist, blk);
-    } else {
-        list_add_descending_by_blocksize(freelist, blk);
+    if (trace_open(&trace, input_file, &nframes) != 0) { // Read frame count
+        fclose(input_file);
+        exit(1);
+    }
+    paging_default_config(&cfg, nframes);
+
+    for (i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            TOUPPER(argv[++i]);
+            if (strcmp(argv[i], "FIFO") == 0)
+                cfg.replacement = PAGE_FIFO;
+            else if (strcmp(argv[i], "LRU") == 0)
+                cfg.replacement = PAGE_LRU;
+            else if (strcmp(argv[i], "CLOCK") == 0)
+                cfg.replacement = PAGE_CLOCK;
+            else if (strcmp(argv[i], "ARC") == 0)
+                cfg.replacement = PAGE_ARC;
+            else
+                cfg.replacement = 0;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 2 < argc) {
+            cfg.tlb_sets = atoi(argv[++i]);
+            cfg.tlb_ways = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            cfg.page_shift = atoi(argv[++i]);
+        } else {
+            cfg.replacement = 0;
+        }
     }
-}
-
-// Sorts the free list by address and merges adjacent free blocks
-list_t* coalese_memory(list_t *list) {
-    list_t *temp_list = list_alloc();
-    block_t *blk;
 
-    // Sort the free list by address
-    while ((blk = list_remove_from_front(list)) != NULL) {
-        list_add_ascending_by_address(temp_list, blk);
+    pg = paging_create(&cfg);
+    if (pg == NULL) {
+        printf(PAGING_USAGE);
+        exit(1);
     }
+    printf("FRAMES = %d\n", nframes);
 
-    // Merge adjacent blocks
-    list_coalese_nodes(temp_list);
+    while ((n = trace_next_refs(&trace, pids, addrs, MMU_CHUNK)) > 0) {
+        if (quiet) {
+            for (i = 0; i < n; i++)
+                paging_access(pg, pids[i], addrs[i], NULL);
+        } else {
+            for (i = 0; i < n; i++) {
+                frame = paging_access(pg, pids[i], addrs[i], &event);
+                printf("PID: %d\t VADDR: 0x%llx\t %s\t FRAME: %d\n", pids[i],
+                       (unsigned long long)addrs[i], events[event], frame);
+            }
+        }
+    }
 
-    return temp_list;
+    paging_print_stats(stdout, pg);
+    paging_destroy(pg);
+    fclose(input_file);
+    return trace.error ? 1 : 0;
 }
 
-// Prints the contents of a list with a message header
-void print_list(list_t *list, char *message) {
-    node_t *current = list->head;
-    block_t *blk;
-    int i = 0;
-
-    printf("%s:\n", message);
+// Main function to simulate memory management
+int main(int argc, char *argv[]) {
+    static trace_t trace;               // Streaming reader for the input file
+    static int inputdata[MMU_CHUNK][2]; // Current chunk of operations
+    int PARTITION_SIZE, N, Memory_Mgt_Policy;
+    FILE *input_file;
+    FILE *snapshot_file = NULL;
+    mmu_options_t opts;
+    mmu_stats_t stats;
+    free_summary_t fs;
+    compact_result_t cr;
+    bitmap_mem_t bm;
+    huge_page_t huge;
+    long sample_every;
+    long problems = 0;
+
+    list_t *FREE_LIST;                  // List of free memory blocks
+    list_t *ALLOC_LIST;                 // List of allocated memory blocks
+    int i, ok, pid, size, scanned;
+
+    if (argc < 3) {
+        printf(MMU_USAGE);
+        printf(PAGING_USAGE);
+        exit(1);
+    }
 
-    while (current != NULL) {
-        blk = current->blk;
-        printf("Block %d:\t START: %d\t END: %d", i, blk->start, blk->end);
+    TOUPPER(argv[2]);
+    if (strcmp(argv[2], "-P") == 0 || strcmp(argv[2], "-PAGING") == 0)
+        return run_paging(argc, argv);
 
-        if (blk->pid != 0)
-            printf("\t PID: %d\n", blk->pid);
-        else
-            printf("\n");
+    FREE_LIST = list_alloc();
+    ALLOC_LIST = list_alloc();
+    get_options(argc, argv, &opts);
+    input_file = get_input(argv, &trace, &PARTITION_SIZE, &Memory_Mgt_Policy);
 
-        current = current->next;
-        i += 1;
+    // The bitmap backend only implements first fit by address, and relocation
+    // would slide huge-page blocks off their huge_size alignment
+    if ((opts.bitmap_unit > 0 && Memory_Mgt_Policy != POLICY_FIRST_FIT) ||
+        (Memory_Mgt_Policy == POLICY_HUGE_PAGE && (opts.compact || opts.compact_budget > 0))) {
+        printf(MMU_USAGE);
+        exit(1);
     }
-}
-
-// Main function to simulate memory management
-int main(int argc, char *argv[]) {
-    int PARTITION_SIZE, inputdata[200][2], N = 0, Memory_Mgt_Policy;
 
-    list_t *FREE_LIST = list_alloc();   // List of free memory blocks
-    list_t *ALLOC_LIST = list_alloc();  // List of allocated memory blocks
-    int i;
+    stats_init(&stats, PARTITION_SIZE);
+    if (opts.bitmap_unit > 0)
+        stats.scan_unit = "words";
+    sample_every = opts.interval > 0 ? opts.interval : MMU_SAMPLE_INTERVAL;
+    if (hugepage_init(&huge, PARTITION_SIZE, opts.huge_size, opts.huge_threshold) != 0) {
+        fprintf(stderr, "Error: cannot allocate huge-page regions\n");
+        exit(1);
+    }
 
-    if (argc != 3) {
-        printf("usage: ./mmu <input file> -{F | B | W }  \n(F=FIFO | B=BESTFIT | W=WORSTFIT)\n");
+    if ((opts.bitmap_unit > 0 || opts.verify) &&
+        bitmap_init(&bm, PARTITION_SIZE, opts.bitmap_unit > 0 ? opts.bitmap_unit : 1) != 0) {
+        fprintf(stderr, "Error: cannot allocate bitmap\n");
         exit(1);
     }
 
-    get_input(argv, inputdata, &N, &PARTITION_SIZE, &Memory_Mgt_Policy);
+    if (opts.snapshot_every > 0) {
+        snapshot_file = fopen(opts.snapshot_path, "w");
+        if (!snapshot_file) {
+            fprintf(stderr, "Error: cannot open snapshot file %s\n", opts.snapshot_path);
+            exit(1);
+        }
+        setvbuf(snapshot_file, NULL, _IOFBF, MMU_SNAPSHOT_BUF);
+    }
 
     // Initialize the free list with the entire partition size
-    block_t *partition = malloc(sizeof(block_t));
+    block_t *partition = block_alloc();
     partition->start = 0;
     partition->end = PARTITION_SIZE + partition->start - 1;
     list_add_to_front(FREE_LIST, partition);
 
-    // Process each input operation
-    for (i = 0; i < N; i++) {
-        printf("************************\n");
-        if (inputdata[i][0] != -99999 && inputdata[i][0] > 0) {
-            printf("ALLOCATE: %d FROM PID: %d\n", inputdata[i][1], inputdata[i][0]);
-            allocate_memory(FREE_LIST, ALLOC_LIST, inputdata[i][0], inputdata[i][1], Memory_Mgt_Policy);
-        } else if (inputdata[i][0] != -99999 && inputdata[i][0] < 0) {
-            printf("DEALLOCATE MEM: PID %d\n", abs(inputdata[i][0]));
-            deallocate_memory(ALLOC_LIST, FREE_LIST, abs(inputdata[i][0]), Memory_Mgt_Policy);
-        } else {
-            printf("COALESCE/COMPACT\n");
-            FREE_LIST = coalese_memory(FREE_LIST);
+    // Stream the trace one chunk at a time and process each operation
+    while ((N = trace_next_chunk(&trace, inputdata, MMU_CHUNK)) > 0) {
+        for (i = 0; i < N; i++) {
+            pid = inputdata[i][0];
+            size = inputdata[i][1];
+
+            if (!opts.quiet)
+                printf("************************\n");
+            if (pid != -99999 && pid > 0) {
+                if (!opts.quiet)
+                    printf("ALLOCATE: %d FROM PID: %d\n", size, pid);
+                if (opts.bitmap_unit > 0)
+                    ok = bitmap_allocate(&bm, ALLOC_LIST, pid, size, &scanned);
+                else if (Memory_Mgt_Policy == POLICY_HUGE_PAGE)
+                    ok = allocate_huge(FREE_LIST, ALLOC_LIST, pid, size, &huge, &scanned);
+                else
+                    ok = allocate_memory(FREE_LIST, ALLOC_LIST, pid, size, Memory_Mgt_Policy, &scanned);
+                stats_record_scan(&stats, scanned);
+                if (!ok && !opts.quiet)
+                    printf("Error: Memory Allocation %d blocks\n", size);
+                stats_record_alloc(&stats, ok > 0, ok);
+            } else if (pid != -99999 && pid < 0) {
+                if (!opts.quiet)
+                    printf("DEALLOCATE MEM: PID %d\n", abs(pid));
+                if (opts.bitmap_unit > 0)
+                    size = bitmap_deallocate(&bm, ALLOC_LIST, abs(pid));
+                else
+                    size = deallocate_memory(ALLOC_LIST, FREE_LIST, abs(pid), Memory_Mgt_Policy);
+                if (size == 0 && !opts.quiet)
+                    printf("Error: Can't locate Memory Used by PID: %d\n", abs(pid));
+                stats_record_dealloc(&stats, size);
+            } else if (opts.bitmap_unit > 0) {
+                // Free runs in the bitmap are always maximal; nothing to merge
+                if (!opts.quiet)
+                    printf("COALESCE/COMPACT\n");
+                stats_record_coalesce(&stats);
+            } else if (opts.compact) {
+                if (!opts.quiet)
+                    printf("COALESCE/COMPACT\n");
+                compact_memory(ALLOC_LIST, FREE_LIST, PARTITION_SIZE, -1, Memory_Mgt_Policy, &cr);
+                if (!opts.quiet)
+                    printf("RELOCATED: %ld blocks, %ld bytes\n", cr.relocations, cr.bytes_moved);
+                stats_record_compaction(&stats, cr.relocations, cr.bytes_moved);
+                stats_record_coalesce(&stats);
+            } else {
+                if (!opts.quiet)
+                    printf("COALESCE/COMPACT\n");
+                list_t *coalesced = coalese_memory(FREE_LIST);
+                list_free(FREE_LIST);
+                FREE_LIST = coalesced;
+                stats_record_coalesce(&stats);
+            }
+
+            // Incremental compaction: a bounded slice of relocation per operation
+            if (opts.compact_budget > 0) {
+                compact_memory(ALLOC_LIST, FREE_LIST, PARTITION_SIZE, opts.compact_budget,
+                               Memory_Mgt_Policy, &cr);
+                if (cr.relocations > 0 && !opts.quiet)
+                    printf("RELOCATED: %ld blocks, %ld bytes\n", cr.relocations, cr.bytes_moved);
+                stats_record_compaction(&stats, cr.relocations, cr.bytes_moved);
+            }
+
+            if (opts.verify && bitmap_verify(&bm, FREE_LIST, ALLOC_LIST) != 0) {
+                fprintf(stderr, "Error: lists are inconsistent after operation %ld\n", stats.ops);
+                problems++;
+            }
+
+            // The bitmap backend materializes its free list only when it is looked at
+            if (opts.bitmap_unit > 0 &&
+                (!opts.quiet || stats.ops % sample_every == 0 ||
+                 (snapshot_file && stats.ops % opts.snapshot_every == 0)))
+                bitmap_free_list(&bm, FREE_LIST);
+
+            if (!opts.quiet) {
+                printf("************************\n");
+                print_list(FREE_LIST, "Free Memory");
+                print_list(ALLOC_LIST, "\nAllocated Memory");
+                printf("\n\n");
+            } else if (stats.ops % sample_every == 0) {
+                fs = stats_sample(&stats, FREE_LIST);
+                if (opts.interval > 0)
+                    stats_print_timeline(stdout, &stats, &fs);
+            }
+
+            if (snapshot_file && stats.ops % opts.snapshot_every == 0) {
+                fprintf(snapshot_file, "OP %ld:\n", stats.ops);
+                fprint_list(snapshot_file, FREE_LIST, "Free Memory");
+                fprint_list(snapshot_file, ALLOC_LIST, "\nAllocated Memory");
+                fprintf(snapshot_file, "\n\n");
+            }
         }
+    }
 
-        printf("************************\n");
-        print_list(FREE_LIST, "Free Memory");
-        print_list(ALLOC_LIST, "\nAllocated Memory");
-        printf("\n\n");
+    if (opts.quiet) {
+        if (opts.bitmap_unit > 0)
+            bitmap_free_list(&bm, FREE_LIST);
+        stats_sample(&stats, FREE_LIST);
+        stats_print(stdout, &stats, FREE_LIST);
+        if (Memory_Mgt_Policy == POLICY_HUGE_PAGE && opts.bitmap_unit == 0) {
+            printf("Huge pages:\t\t %d bytes, threshold %d\n", huge.huge_size, huge.threshold);
+            printf("Huge/small allocs:\t %ld / %ld\n", huge.huge_allocs, huge.small_allocs);
+            printf("Alignment waste:\t %lld bytes (%.1f per huge alloc)\n", huge.align_waste,
+                   huge.huge_allocs > 0 ? (double)huge.align_waste / huge.huge_allocs : 0.0);
+            printf("Regions broken:\t\t %ld (%ld reclaimed, %ld intact regions free)\n",
+                   huge.regions_broken, huge.regions_reclaimed, hugepage_free_regions(FREE_LIST, &huge));
+        }
     }
 
+    if (snapshot_file)
+        fclose(snapshot_file);
+    fclose(input_file);
     list_free(FREE_LIST);
     list_free(ALLOC_LIST);
+    list_pool_reset();
+    if (opts.bitmap_unit > 0 || opts.verify)
+        bitmap_destroy(&bm);
+    hugepage_destroy(&huge);
 
-    return 0;
+    return trace.error || problems > 0 ? 1 : 0;
 }
@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mtalloc.h"
+
+// A cached block is reused if it wastes at most 1/8 of the request
+#define MT_CACHE_SLACK(size) ((size) + (size) / 8)
+
+// Ring slot of the i-th oldest cached block
+#define MT_CACHE_SLOT(c, i) (((c)->head + (i)) % MT_CACHE_SLOTS)
+
+// Sets up an arena owning [start, end] as a single free range
+static void arena_init(mt_arena_t *ar, int start, int end) {
+    mt_free_t *f;
+
+    pthread_mutex_init(&ar->lock, NULL);
+    pool_init(&ar->nodes, sizeof(mt_free_t), 256);
+    ar->start = start;
+    ar->end = end;
+    ar->head = NULL;
+
+    if (end >= start) {
+        f = pool_get(&ar->nodes);
+        f->start = start;
+        f->end = end;
+        f->next = NULL;
+        ar->head = f;
+    }
+}
+
+// First fit within one arena; caller holds the arena lock
+static int arena_alloc(mt_arena_t *ar, int size, block_t *out) {
+    mt_free_t *prev = NULL;
+    mt_free_t *cur = ar->head;
+
+    while (cur != NULL && cur->end - cur->start + 1 < size) {
+        prev = cur;
+        cur = cur->next;
+    }
+    if (cur == NULL)
+        return 0;
+
+    out->start = cur->start;
+    out->end = cur->start + size - 1;
+
+    if (cur->end - cur->start + 1 == size) { // Exact fit: unlink the range
+        if (prev == NULL)
+            ar->head = cur->next;
+        else
+            prev->next = cur->next;
+        pool_put(&ar->nodes, cur);
+    } else {
+        cur->start += size;
+    }
+    return 1;
+}
+
+// Inserts a range in address order, merging with its neighbours; caller holds the lock
+static void arena_free(mt_arena_t *ar, int start, int end) {
+    mt_free_t *prev = NULL;
+    mt_free_t *cur = ar->head;
+    mt_free_t *f;
+
+    while (cur != NULL && cur->start < start) {
+        prev = cur;
+        cur = cur->next;
+    }
+
+    if (prev != NULL && prev->end + 1 == start) { // Merge into the previous range
+        prev->end = end;
+        if (cur != NULL && end + 1 == cur->start) {
+            prev->end = cur->end;
+            prev->next = cur->next;
+            pool_put(&ar->nodes, cur);
+        }
+        return;
+    }
+
+    if (cur != NULL && end + 1 == cur->start) { // Merge into the next range
+        cur->start = start;
+        return;
+    }
+
+    f = pool_get(&ar->nodes);
+    f->start = start;
+    f->end = end;
+    f->next = cur;
+    if (prev == NULL)
+        ar->head = f;
+    else
+        prev->next = f;
+}
+
+// Finds the arena that owns an address
+static mt_arena_t *arena_of(mt_alloc_t *a, int addr) {
+    int i;
+
+    if (a->mode == MT_GLOBAL_LOCK)
+        return &a->arenas[0];
+
+    i = a->arena_span > 0 ? addr / a->arena_span : a->narenas;
+    if (i > a->narenas)
+        i = a->narenas;
+    if (addr > a->arenas[i].end || addr < a->arenas[i].start)
+        i = a->narenas;
+    return &a->arenas[i];
+}
+
+mt_alloc_t *mt_create(int partition_size, int mode, int narenas, double arena_share) {
+    mt_alloc_t *a = malloc(sizeof(mt_alloc_t));
+    int i;
+
+    if (a == NULL)
+        return NULL;
+
+    a->mode = mode;
+    if (mode == MT_GLOBAL_LOCK) {
+        a->narenas = 0;
+        a->arena_span = 0;
+        arena_init(&a->arenas[0], 0, partition_size - 1);
+        return a;
+    }
+
+    if (narenas < 1)
+        narenas = 1;
+    if (narenas > MT_MAX_ARENAS)
+        narenas = MT_MAX_ARENAS;
+    a->narenas = narenas;
+    a->arena_span = (int)(partition_size * arena_share) / narenas;
+
+    for (i = 0; i < narenas; i++)
+        arena_init(&a->arenas[i], i * a->arena_span, (i + 1) * a->arena_span - 1);
+
+    // The central arena takes whatever the shards do not own
+    arena_init(&a->arenas[narenas], narenas * a->arena_span, partition_size - 1);
+    return a;
+}
+
+void mt_destroy(mt_alloc_t *a) {
+    int i, n = a->mode == MT_GLOBAL_LOCK ? 1 : a->narenas + 1;
+
+    for (i = 0; i < n; i++) {
+        pthread_mutex_destroy(&a->arenas[i].lock);
+        pool_destroy(&a->arenas[i].nodes);
+    }
+    free(a);
+}
+
+void mt_cache_init(mt_cache_t *c, int tid) {
+    c->tid = tid;
+    c->head = 0;
+    c->count = 0;
+    c->allocs = 0;
+    c->cache_hits = 0;
+    c->central_allocs = 0;
+    c->fails = 0;
+}
+
+// Returns one block to its owning arena
+static void release_to_arena(mt_alloc_t *a, const block_t *blk) {
+    mt_arena_t *ar = arena_of(a, blk->start);
+
+    pthread_mutex_lock(&ar->lock);
+    arena_free(ar, blk->start, blk->end);
+    pthread_mutex_unlock(&ar->lock);
+}
+
+void mt_cache_flush(mt_alloc_t *a, mt_cache_t *c) {
+    int i;
+
+    for (i = 0; i < c->count; i++)
+        release_to_arena(a, &c->slots[MT_CACHE_SLOT(c, i)]);
+    c->head = 0;
+    c->count = 0;
+}
+
+// Tries one arena under its lock
+static int try_arena(mt_arena_t *ar, int size, block_t *out) {
+    int ok;
+
+    pthread_mutex_lock(&ar->lock);
+    ok = arena_alloc(ar, size, out);
+    pthread_mutex_unlock(&ar->lock);
+    return ok;
+}
+
+int mt_allocate(mt_alloc_t *a, mt_cache_t *c, int size, block_t *out) {
+    int i, sz;
+
+    c->allocs++;
+
+    if (a->mode == MT_GLOBAL_LOCK) {
+        if (try_arena(&a->arenas[0], size, out))
+            return 1;
+        c->fails++;
+        return 0;
+    }
+
+    // 1. Lock-free reuse of the newest cached block of about the right size
+    for (i = c->count - 1; i >= 0; i--) {
+        const block_t *blk = &c->slots[MT_CACHE_SLOT(c, i)];
+
+        sz = blk->end - blk->start + 1;
+        if (sz >= size && sz <= MT_CACHE_SLACK(size)) {
+            *out = *blk;
+            // Close the gap by moving the newer blocks back, keeping age order
+            for (; i < c->count - 1; i++)
+                c->slots[MT_CACHE_SLOT(c, i)] = c->slots[MT_CACHE_SLOT(c, i + 1)];
+            c->count--;
+            c->cache_hits++;
+            return 1;
+        }
+    }
+
+    // 2. The thread's own arena
+    if (try_arena(&a->arenas[c->tid % a->narenas], size, out))
+        return 1;
+
+    // 3. The central arena
+    if (try_arena(&a->arenas[a->narenas], size, out)) {
+        c->central_allocs++;
+        return 1;
+    }
+
+    // 4. Out of memory: give cached blocks back so they can coalesce, then
+    // retry both arenas, since flushed blocks may belong to the central one
+    if (c->count > 0) {
+        mt_cache_flush(a, c);
+        if (try_arena(&a->arenas[c->tid % a->narenas], size, out))
+            return 1;
+        if (try_arena(&a->arenas[a->narenas], size, out)) {
+            c->central_allocs++;
+            return 1;
+        }
+    }
+
+    c->fails++;
+    return 0;
+}
+
+void mt_deallocate(mt_alloc_t *a, mt_cache_t *c, const block_t *blk) {
+    if (a->mode == MT_GLOBAL_LOCK) {
+        release_to_arena(a, blk);
+        return;
+    }
+
+    // Evict the oldest cached block to make room
+    if (c->count == MT_CACHE_SLOTS) {
+        release_to_arena(a, &c->slots[c->head]);
+        c->head = (c->head + 1) % MT_CACHE_SLOTS;
+        c->count--;
+    }
+    c->slots[MT_CACHE_SLOT(c, c->count)] = *blk;
+    c->count++;
+}
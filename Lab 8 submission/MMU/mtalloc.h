@@ -0,0 +1,79 @@
+#ifndef MTALLOC_H
+#define MTALLOC_H
+
+#include <pthread.h>
+#include "list.h"
+#include "pool.h"
+
+/**
+ * Concurrent contiguous allocator.
+ *
+ * The partition is split into sharded arenas, each with its own lock and
+ * address-ordered free list, plus a locked central region used as a
+ * fallback. Threads pick an arena by thread id and keep a small private
+ * cache of recently freed blocks that is reused without taking any lock.
+ * MT_GLOBAL_LOCK instead puts the whole partition behind a single lock
+ * with no caches, as a baseline.
+ */
+
+#define MT_GLOBAL_LOCK 0
+#define MT_SHARDED 1
+
+#define MT_MAX_ARENAS 64
+#define MT_CACHE_SLOTS 32
+
+// Free range inside an arena, kept in address order
+typedef struct mt_free {
+  int start;
+  int end;
+  struct mt_free *next;
+} mt_free_t;
+
+// One lockable region of the partition
+typedef struct mt_arena {
+  pthread_mutex_t lock;
+  int start;                // first address owned by the arena
+  int end;                  // last address owned by the arena
+  mt_free_t *head;          // address-ordered free ranges
+  pool_t nodes;             // mt_free_t nodes, only touched under lock
+} mt_arena_t;
+
+typedef struct mt_alloc {
+  int mode;
+  int narenas;              // sharded arenas; the central arena follows them
+  int arena_span;           // bytes owned by each sharded arena
+  mt_arena_t arenas[MT_MAX_ARENAS + 1];
+} mt_alloc_t;
+
+/* Per-thread state. Each thread owns one cache and must not share it.
+ * The cache is a FIFO ring of recently freed blocks: allocation reuses the
+ * newest block that fits, and a free into a full cache evicts the oldest. */
+typedef struct mt_cache {
+  int tid;
+  block_t slots[MT_CACHE_SLOTS];  // ring, oldest block at head
+  int head;                 // slot of the oldest cached block
+  int count;
+  long allocs;
+  long cache_hits;
+  long central_allocs;      // allocations served by the central arena
+  long fails;
+} mt_cache_t;
+
+/* Creates an allocator over partition_size bytes. In MT_SHARDED mode,
+ * narenas arenas share arena_share of the partition and the rest is central. */
+mt_alloc_t *mt_create(int partition_size, int mode, int narenas, double arena_share);
+void mt_destroy(mt_alloc_t *a);
+
+void mt_cache_init(mt_cache_t *c, int tid);
+
+/* Returns every cached block to its arena. */
+void mt_cache_flush(mt_alloc_t *a, mt_cache_t *c);
+
+/* Allocates size bytes into *out. Returns 1 on success, 0 on failure.
+ * The block may be slightly larger than requested when served from cache. */
+int mt_allocate(mt_alloc_t *a, mt_cache_t *c, int size, block_t *out);
+
+/* Releases a block previously returned by mt_allocate. */
+void mt_deallocate(mt_alloc_t *a, mt_cache_t *c, const block_t *blk);
+
+#endif				// MTALLOC_H
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "util.h"
+#include "mtalloc.h"
+
+/**
+ * Multi-threaded allocator replay.
+ *
+ * Each trace is loaded once and split by pid across the threads, so every
+ * thread replays the allocations and frees of its own processes in trace
+ * order against one shared allocator. This runs for 1, 2, 4 ... max threads,
+ * once with the sharded allocator and once with a single global lock, and
+ * writes one CSV row per (trace, mode, threads). The traces are the same
+ * ones mmubench replays; COALESCE/COMPACT lines are skipped because the
+ * arenas coalesce on every free.
+ */
+
+#define MTBENCH_USAGE "usage: ./mtbench [-o <csv file>] [-t <max threads>] <trace file> [trace file ...]\n"
+
+// Operations read per chunk
+#define MTBENCH_CHUNK 4096
+
+// One replayed operation: an allocation of size bytes, or a free (size 0).
+// slot names the allocation both refer to; -1 frees an unknown pid.
+typedef struct mt_op {
+    int pid;
+    int size;
+    int slot;
+} mt_op_t;
+
+typedef struct mt_trace {
+    const char *path;
+    int partition;
+    mt_op_t *ops;
+    long nops;
+    int nslots;               // allocations in the trace
+} mt_trace_t;
+
+typedef struct worker {
+    pthread_t thread;
+    mt_alloc_t *alloc;
+    mt_cache_t cache;
+    const mt_op_t *ops;       // this thread's share, in trace order
+    long nops;
+    block_t *blocks;          // shared by slot; a slot is only touched by its pid's thread
+} worker_t;
+
+// Monotonic clock in seconds
+static double now_sec(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Open-addressing pid -> slot map, only used while loading a trace
+static int *pid_find(int *keys, int mask, int pid) {
+    int h = (int)(((uint32_t)pid * 2654435761u) & (uint32_t)mask);
+
+    while (keys[2 * h] != 0 && keys[2 * h] != pid)
+        h = (h + 1) & mask;
+    return &keys[2 * h];
+}
+
+// Reads a whole trace and resolves every free to the allocation it releases
+static int load_trace(const char *path, mt_trace_t *tr) {
+    trace_t *trace;
+    int (*chunk)[2];
+    int *keys, *e;
+    FILE *f;
+    long cap = MTBENCH_CHUNK, i;
+    int n, k, mask;
+
+    f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: Invalid filepath %s\n", path);
+        return -1;
+    }
+    trace = malloc(sizeof(*trace));
+    chunk = malloc(MTBENCH_CHUNK * sizeof(*chunk));
+    tr->ops = malloc(cap * sizeof(mt_op_t));
+    if (trace == NULL || chunk == NULL || tr->ops == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    tr->path = path;
+    tr->nops = 0;
+    tr->nslots = 0;
+    if (trace_open(trace, f, &tr->partition) != 0) {
+        fprintf(stderr, "Error: %s has no partition size\n", path);
+        free(trace);
+        free(chunk);
+        free(tr->ops);
+        fclose(f);
+        return -1;
+    }
+
+    while ((n = trace_next_chunk(trace, chunk, MTBENCH_CHUNK)) > 0) {
+        for (k = 0; k < n; k++) {
+            if (chunk[k][0] == -99999 || chunk[k][0] == 0)
+                continue;
+            if (tr->nops == cap) {
+                mt_op_t *grown = realloc(tr->ops, 2 * cap * sizeof(mt_op_t));
+
+                if (grown == NULL) {
+                    fprintf(stderr, "Error: out of memory\n");
+                    exit(1);
+                }
+                tr->ops = grown;
+                cap *= 2;
+            }
+            tr->ops[tr->nops].pid = chunk[k][0] > 0 ? chunk[k][0] : -chunk[k][0];
+            tr->ops[tr->nops].size = chunk[k][0] > 0 ? chunk[k][1] : 0;
+            tr->nops++;
+        }
+    }
+    if (trace->error) {
+        fprintf(stderr, "Error: malformed trace %s\n", path);
+        exit(1);
+    }
+    free(chunk);
+    free(trace);
+    fclose(f);
+
+    // Give each allocation a slot and point its free at the same slot
+    for (mask = 1; mask < 2 * tr->nops; mask *= 2)
+        ;
+    keys = calloc(2 * mask, sizeof(int));
+    if (keys == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    mask--;
+    for (i = 0; i < tr->nops; i++) {
+        e = pid_find(keys, mask, tr->ops[i].pid);
+        if (tr->ops[i].size > 0) {
+            e[0] = tr->ops[i].pid;
+            e[1] = tr->ops[i].slot = tr->nslots++;
+        } else {
+            tr->ops[i].slot = e[0] != 0 ? e[1] : -1;
+        }
+    }
+    free(keys);
+    return 0;
+}
+
+static void *worker_run(void *arg) {
+    worker_t *w = arg;
+    block_t *blk;
+    long i;
+
+    for (i = 0; i < w->nops; i++) {
+        const mt_op_t *op = &w->ops[i];
+
+        if (op->size > 0) {
+            blk = &w->blocks[op->slot];
+            if (mt_allocate(w->alloc, &w->cache, op->size, blk))
+                blk->pid = op->pid;
+        } else if (op->slot >= 0 && w->blocks[op->slot].pid != 0) {
+            blk = &w->blocks[op->slot];
+            mt_deallocate(w->alloc, &w->cache, blk);
+            blk->pid = 0;
+        }
+    }
+
+    // Leave the allocator as it was found
+    for (i = 0; i < w->nops; i++) {
+        blk = w->ops[i].size > 0 ? &w->blocks[w->ops[i].slot] : NULL;
+        if (blk != NULL && blk->pid != 0) {
+            mt_deallocate(w->alloc, &w->cache, blk);
+            blk->pid = 0;
+        }
+    }
+    mt_cache_flush(w->alloc, &w->cache);
+    return NULL;
+}
+
+// Runs one (trace, mode, thread count) configuration and reports a CSV row
+static void run(FILE *out, const mt_trace_t *tr, int mode, int nthreads) {
+    mt_alloc_t *a = mt_create(tr->partition, mode, nthreads, 0.75);
+    worker_t *w = calloc(nthreads, sizeof(worker_t));
+    mt_op_t *split = malloc(tr->nops * sizeof(mt_op_t));
+    block_t *blocks = calloc(tr->nslots > 0 ? tr->nslots : 1, sizeof(block_t));
+    long allocs = 0, hits = 0, central = 0, fails = 0, i, pos;
+    double t0, elapsed;
+    int t;
+
+    if (a == NULL || w == NULL || split == NULL || blocks == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+
+    // Thread pid % nthreads owns every operation of that pid
+    for (i = 0; i < tr->nops; i++)
+        w[tr->ops[i].pid % nthreads].nops++;
+    for (t = 0, pos = 0; t < nthreads; t++) {
+        w[t].ops = split + pos;
+        pos += w[t].nops;
+        w[t].nops = 0;
+    }
+    for (i = 0; i < tr->nops; i++) {
+        worker_t *owner = &w[tr->ops[i].pid % nthreads];
+
+        split[owner->ops - split + owner->nops++] = tr->ops[i];
+    }
+
+    for (t = 0; t < nthreads; t++) {
+        w[t].alloc = a;
+        w[t].blocks = blocks;
+        mt_cache_init(&w[t].cache, t);
+    }
+
+    t0 = now_sec();
+    for (t = 0; t < nthreads; t++)
+        pthread_create(&w[t].thread, NULL, worker_run, &w[t]);
+    for (t = 0; t < nthreads; t++)
+        pthread_join(w[t].thread, NULL);
+    elapsed = now_sec() - t0;
+
+    for (t = 0; t < nthreads; t++) {
+        allocs += w[t].cache.allocs;
+        hits += w[t].cache.cache_hits;
+        central += w[t].cache.central_allocs;
+        fails += w[t].cache.fails;
+    }
+
+    fprintf(out, "%s,%s,%d,%ld,%.4f,%.1f,%.4f,%.4f,%.4f\n",
+            tr->path, mode == MT_SHARDED ? "sharded" : "global_lock", nthreads, tr->nops,
+            elapsed, tr->nops / elapsed,
+            allocs > 0 ? (double)hits / allocs : 0.0,
+            allocs > 0 ? (double)central / allocs : 0.0,
+            allocs > 0 ? (double)fails / allocs : 0.0);
+    fflush(out);
+
+    free(blocks);
+    free(split);
+    free(w);
+    mt_destroy(a);
+}
+
+int main(int argc, char *argv[]) {
+    FILE *out = stdout;
+    mt_trace_t tr;
+    int max_threads = 64;
+    int first = 1, threads, i;
+
+    while (first + 1 < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-o") == 0) {
+            out = fopen(argv[first + 1], "w");
+            if (!out) {
+                fprintf(stderr, "Error: cannot open %s\n", argv[first + 1]);
+                exit(1);
+            }
+        } else if (strcmp(argv[first], "-t") == 0) {
+            max_threads = atoi(argv[first + 1]);
+        } else {
+            break;
+        }
+        first += 2;
+    }
+    if (first >= argc || max_threads < 1 || max_threads > MT_MAX_ARENAS) {
+        printf(MTBENCH_USAGE);
+        exit(1);
+    }
+
+    fprintf(out, "trace,mode,threads,ops,seconds,ops_per_sec,cache_hit_rate,central_rate,fail_rate\n");
+    for (i = first; i < argc; i++) {
+        if (load_trace(argv[i], &tr) != 0)
+            exit(1);
+        for (threads = 1; threads <= max_threads; threads *= 2) {
+            run(out, &tr, MT_GLOBAL_LOCK, threads);
+            run(out, &tr, MT_SHARDED, threads);
+        }
+        free(tr.ops);
+    }
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
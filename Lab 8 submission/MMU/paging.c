@@ -0,0 +1,630 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "paging.h"
+#include "pool.h"
+
+#define PT_FANOUT (1 << PAGING_LEVEL_BITS)
+#define VA_MASK ((((uint64_t)1) << PAGING_VA_BITS) - 1)
+#define NIL (-1)
+
+// Interior page-table node: pointers to the next level
+typedef struct pt_node {
+    void *child[PT_FANOUT];
+} pt_node_t;
+
+// Last-level node: frame + 1 for each page, 0 when the page is not resident
+typedef struct pt_leaf {
+    int32_t pte[PT_FANOUT];
+} pt_leaf_t;
+
+// Per-process page-table root, kept in an open-addressing table keyed by pid
+typedef struct proc {
+    int pid;                // 0 marks an empty slot
+    pt_node_t *root;
+} proc_t;
+
+// ARC directory entry: a resident page (T1/T2) or a ghost (B1/B2)
+typedef struct arc_entry {
+    uint64_t key;
+    int frame;              // NIL for ghosts
+    int list;
+    int prev, next;         // neighbours in the entry's list
+    int hnext;              // next entry in the hash chain
+} arc_entry_t;
+
+enum { ARC_T1, ARC_T2, ARC_B1, ARC_B2, ARC_LISTS };
+
+typedef struct arc_list {
+    int head;               // MRU end
+    int tail;               // LRU end
+    int size;
+} arc_list_t;
+
+struct paging {
+    paging_config_t cfg;
+    paging_stats_t stats;
+    int levels;             // page-table depth
+    int top_shift;          // bit position of the top-level index in the vpn
+
+    // Processes
+    proc_t *procs;
+    int procs_cap;          // power of two
+    int last_pid;           // one-entry cache for the common case
+    pt_node_t *last_root;
+    pool_t nodes;
+    pool_t leaves;
+
+    // Physical frames
+    int used;               // frames handed out so far (0..used-1 are resident)
+    uint64_t *frame_key;
+    int32_t **frame_pte;
+    uint8_t *ref;           // Clock reference bits
+    int *lru_prev, *lru_next;
+    int lru_head, lru_tail; // MRU / LRU ends
+    int hand;               // FIFO and Clock hand
+
+    // TLB
+    int tlb_mask;           // tlb_sets - 1
+    uint64_t *tlb_key;      // 0 = invalid (keys always carry a pid > 0)
+    int *tlb_frame;
+    uint64_t *tlb_stamp;
+    uint64_t clock;         // global LRU stamp
+
+    // ARC
+    arc_entry_t *arc;
+    int *arc_free;          // stack of unused entries
+    int arc_nfree;
+    int *arc_bucket;
+    int arc_hbits;
+    int *frame_entry;       // resident frame -> its entry
+    arc_list_t lists[ARC_LISTS];
+    int arc_p;              // target size of T1
+};
+
+static const char *policy_names[] = { "NONE", "FIFO", "LRU", "CLOCK", "ARC" };
+
+const char *paging_policy_name(int replacement) {
+    if (replacement < PAGE_FIFO || replacement > PAGE_ARC)
+        return policy_names[0];
+    return policy_names[replacement];
+}
+
+void paging_default_config(paging_config_t *cfg, int nframes) {
+    cfg->nframes = nframes;
+    cfg->page_shift = 12;
+    cfg->tlb_sets = 64;
+    cfg->tlb_ways = 4;
+    cfg->replacement = PAGE_LRU;
+    cfg->tlb_ns = 1.0;
+    cfg->mem_ns = 100.0;
+    cfg->fault_ns = 100000.0;
+}
+
+// Fibonacci hash of a 64-bit key down to bits bits
+static inline uint64_t hash_key(uint64_t key, int bits) {
+    return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+// Packs pid (at most PAGING_MAX_PID) and vpn into one nonzero key
+static inline uint64_t make_key(int pid, uint64_t vpn) {
+    return ((uint64_t)pid << PAGING_KEY_VPN_BITS) | vpn;
+}
+
+/* ---------- process table ---------- */
+
+static pt_node_t *new_node(paging_t *pg) {
+    pt_node_t *n = pool_get(&pg->nodes);
+
+    memset(n, 0, sizeof(*n));
+    pg->stats.table_nodes++;
+    return n;
+}
+
+static pt_leaf_t *new_leaf(paging_t *pg) {
+    pt_leaf_t *l = pool_get(&pg->leaves);
+
+    memset(l, 0, sizeof(*l));
+    pg->stats.table_nodes++;
+    return l;
+}
+
+// Doubles the process table and reinserts every process
+static void procs_grow(paging_t *pg) {
+    proc_t *old = pg->procs;
+    int old_cap = pg->procs_cap;
+    int i, j;
+
+    pg->procs_cap *= 2;
+    pg->procs = calloc(pg->procs_cap, sizeof(proc_t));
+    for (i = 0; i < old_cap; i++) {
+        if (old[i].pid == 0)
+            continue;
+        j = (int)((unsigned)old[i].pid * 2654435761u) & (pg->procs_cap - 1);
+        while (pg->procs[j].pid != 0)
+            j = (j + 1) & (pg->procs_cap - 1);
+        pg->procs[j] = old[i];
+    }
+    free(old);
+}
+
+// Returns the page-table root of pid, creating the process on first use
+static pt_node_t *proc_root(paging_t *pg, int pid) {
+    int j;
+
+    if (pid == pg->last_pid)
+        return pg->last_root;
+
+    j = (int)((unsigned)pid * 2654435761u) & (pg->procs_cap - 1);
+    while (pg->procs[j].pid != 0 && pg->procs[j].pid != pid)
+        j = (j + 1) & (pg->procs_cap - 1);
+
+    if (pg->procs[j].pid == 0) {
+        if (2 * (pg->stats.processes + 1) > (uint64_t)pg->procs_cap) {
+            procs_grow(pg);
+            return proc_root(pg, pid);
+        }
+        pg->procs[j].pid = pid;
+        pg->procs[j].root = new_node(pg);
+        pg->stats.processes++;
+    }
+
+    pg->last_pid = pid;
+    pg->last_root = pg->procs[j].root;
+    return pg->last_root;
+}
+
+// Walks (and grows) pid's page table down to the PTE for vpn
+static int32_t *walk(paging_t *pg, int pid, uint64_t vpn) {
+    pt_node_t *node = proc_root(pg, pid);
+    int shift = pg->top_shift;
+    int level, idx;
+
+    for (level = 1; level < pg->levels; level++) {
+        idx = (int)(vpn >> shift) & (PT_FANOUT - 1);
+        if (node->child[idx] == NULL)
+            node->child[idx] = level == pg->levels - 1 ? (void *)new_leaf(pg) : (void *)new_node(pg);
+        node = node->child[idx];
+        shift -= PAGING_LEVEL_BITS;
+    }
+    pg->stats.walk_levels += pg->levels;
+    return &((pt_leaf_t *)node)->pte[vpn & (PT_FANOUT - 1)];
+}
+
+/* ---------- TLB ---------- */
+
+static inline int tlb_set(const paging_t *pg, uint64_t key) {
+    return (int)(hash_key(key, 32) & (uint64_t)pg->tlb_mask) * pg->cfg.tlb_ways;
+}
+
+static void tlb_insert(paging_t *pg, uint64_t key, int frame) {
+    int base = tlb_set(pg, key);
+    int w, victim = base;
+
+    for (w = base; w < base + pg->cfg.tlb_ways; w++) {
+        if (pg->tlb_key[w] == 0) {
+            victim = w;
+            break;
+        }
+        if (pg->tlb_stamp[w] < pg->tlb_stamp[victim])
+            victim = w;
+    }
+    pg->tlb_key[victim] = key;
+    pg->tlb_frame[victim] = frame;
+    pg->tlb_stamp[victim] = pg->clock;
+}
+
+// Shoots down the translation of an evicted page
+static void tlb_invalidate(paging_t *pg, uint64_t key) {
+    int base, w;
+
+    if (pg->cfg.tlb_sets == 0)
+        return;
+    base = tlb_set(pg, key);
+    for (w = base; w < base + pg->cfg.tlb_ways; w++) {
+        if (pg->tlb_key[w] == key) {
+            pg->tlb_key[w] = 0;
+            return;
+        }
+    }
+}
+
+/* ---------- LRU frame list ---------- */
+
+static void lru_unlink(paging_t *pg, int f) {
+    if (pg->lru_prev[f] != NIL)
+        pg->lru_next[pg->lru_prev[f]] = pg->lru_next[f];
+    else
+        pg->lru_head = pg->lru_next[f];
+    if (pg->lru_next[f] != NIL)
+        pg->lru_prev[pg->lru_next[f]] = pg->lru_prev[f];
+    else
+        pg->lru_tail = pg->lru_prev[f];
+}
+
+static void lru_push(paging_t *pg, int f) {
+    pg->lru_prev[f] = NIL;
+    pg->lru_next[f] = pg->lru_head;
+    if (pg->lru_head != NIL)
+        pg->lru_prev[pg->lru_head] = f;
+    pg->lru_head = f;
+    if (pg->lru_tail == NIL)
+        pg->lru_tail = f;
+}
+
+/* ---------- ARC ---------- */
+
+static void arc_unlink(paging_t *pg, int e) {
+    arc_entry_t *a = pg->arc;
+    arc_list_t *l = &pg->lists[a[e].list];
+
+    if (a[e].prev != NIL)
+        a[a[e].prev].next = a[e].next;
+    else
+        l->head = a[e].next;
+    if (a[e].next != NIL)
+        a[a[e].next].prev = a[e].prev;
+    else
+        l->tail = a[e].prev;
+    l->size--;
+}
+
+static void arc_push(paging_t *pg, int e, int list) {
+    arc_entry_t *a = pg->arc;
+    arc_list_t *l = &pg->lists[list];
+
+    a[e].list = list;
+    a[e].prev = NIL;
+    a[e].next = l->head;
+    if (l->head != NIL)
+        a[l->head].prev = e;
+    l->head = e;
+    if (l->tail == NIL)
+        l->tail = e;
+    l->size++;
+}
+
+static int arc_find(paging_t *pg, uint64_t key) {
+    int e = pg->arc_bucket[hash_key(key, pg->arc_hbits)];
+
+    while (e != NIL && pg->arc[e].key != key)
+        e = pg->arc[e].hnext;
+    return e;
+}
+
+static int arc_new(paging_t *pg, uint64_t key) {
+    int e = pg->arc_free[--pg->arc_nfree];
+    int b = (int)hash_key(key, pg->arc_hbits);
+
+    pg->arc[e].key = key;
+    pg->arc[e].frame = NIL;
+    pg->arc[e].hnext = pg->arc_bucket[b];
+    pg->arc_bucket[b] = e;
+    return e;
+}
+
+// Removes an entry from its list and the directory
+static void arc_delete(paging_t *pg, int e) {
+    int b = (int)hash_key(pg->arc[e].key, pg->arc_hbits);
+    int *link = &pg->arc_bucket[b];
+
+    while (*link != e)
+        link = &pg->arc[*link].hnext;
+    *link = pg->arc[e].hnext;
+
+    arc_unlink(pg, e);
+    pg->arc_free[pg->arc_nfree++] = e;
+}
+
+/* ---------- frames ---------- */
+
+// Unmaps a resident page so its frame can be reused
+static void evict(paging_t *pg, int f) {
+    *pg->frame_pte[f] = 0;
+    tlb_invalidate(pg, pg->frame_key[f]);
+    pg->stats.evictions++;
+}
+
+// ARC's REPLACE: demotes the LRU page of T1 or T2 to its ghost list
+static int arc_replace(paging_t *pg, int in_b2) {
+    arc_list_t *t1 = &pg->lists[ARC_T1];
+    int e, f;
+
+    if (pg->used < pg->cfg.nframes)
+        return pg->used++;
+
+    if (t1->size > 0 &&
+        ((in_b2 && t1->size == pg->arc_p) || t1->size > pg->arc_p || pg->lists[ARC_T2].size == 0)) {
+        e = t1->tail;
+        arc_unlink(pg, e);
+        arc_push(pg, e, ARC_B1);
+    } else {
+        e = pg->lists[ARC_T2].tail;
+        arc_unlink(pg, e);
+        arc_push(pg, e, ARC_B2);
+    }
+
+    f = pg->arc[e].frame;
+    pg->arc[e].frame = NIL;
+    evict(pg, f);
+    return f;
+}
+
+// Handles a page fault under ARC and returns the frame for the new page
+static int arc_fault(paging_t *pg, uint64_t key) {
+    arc_list_t *l = pg->lists;
+    int c = pg->cfg.nframes;
+    int e = arc_find(pg, key);
+    int f, delta, total;
+
+    if (e != NIL) {
+        // Ghost hit: adapt the T1 target toward the list that would have hit
+        if (pg->arc[e].list == ARC_B1) {
+            delta = l[ARC_B1].size >= l[ARC_B2].size ? 1 : l[ARC_B2].size / l[ARC_B1].size;
+            pg->arc_p = pg->arc_p + delta < c ? pg->arc_p + delta : c;
+            f = arc_replace(pg, 0);
+        } else {
+            delta = l[ARC_B2].size >= l[ARC_B1].size ? 1 : l[ARC_B1].size / l[ARC_B2].size;
+            pg->arc_p = pg->arc_p - delta > 0 ? pg->arc_p - delta : 0;
+            f = arc_replace(pg, 1);
+        }
+        arc_unlink(pg, e);
+        arc_push(pg, e, ARC_T2);
+    } else {
+        if (l[ARC_T1].size + l[ARC_B1].size == c) {
+            if (l[ARC_T1].size < c) {
+                arc_delete(pg, l[ARC_B1].tail);
+                f = arc_replace(pg, 0);
+            } else {
+                // T1 fills the cache: drop its LRU page outright
+                e = l[ARC_T1].tail;
+                f = pg->arc[e].frame;
+                evict(pg, f);
+                arc_delete(pg, e);
+            }
+        } else {
+            total = l[ARC_T1].size + l[ARC_T2].size + l[ARC_B1].size + l[ARC_B2].size;
+            if (total >= c) {
+                if (total == 2 * c)
+                    arc_delete(pg, l[ARC_B2].tail);
+                f = arc_replace(pg, 0);
+            } else {
+                f = pg->used++;
+            }
+        }
+        e = arc_new(pg, key);
+        arc_push(pg, e, ARC_T1);
+    }
+
+    pg->arc[e].frame = f;
+    pg->frame_entry[f] = e;
+    return f;
+}
+
+// Records a reference to a resident frame
+static inline void touch(paging_t *pg, int f) {
+    int e;
+
+    switch (pg->cfg.replacement) {
+        case PAGE_LRU:
+            if (pg->lru_head != f) {
+                lru_unlink(pg, f);
+                lru_push(pg, f);
+            }
+            break;
+        case PAGE_CLOCK:
+            pg->ref[f] = 1;
+            break;
+        case PAGE_ARC:
+            e = pg->frame_entry[f];
+            arc_unlink(pg, e);
+            arc_push(pg, e, ARC_T2);
+            break;
+    }
+}
+
+// Picks the frame for a faulting page, evicting a resident page if needed
+static int take_frame(paging_t *pg, uint64_t key) {
+    int f;
+
+    if (pg->cfg.replacement == PAGE_ARC)
+        return arc_fault(pg, key);
+
+    if (pg->used < pg->cfg.nframes) {
+        f = pg->used++;
+    } else {
+        switch (pg->cfg.replacement) {
+            case PAGE_FIFO: // Frames fill in order, so the hand always points at the oldest
+                f = pg->hand;
+                pg->hand = (pg->hand + 1) % pg->cfg.nframes;
+                break;
+            case PAGE_CLOCK:
+                while (pg->ref[pg->hand]) {
+                    pg->ref[pg->hand] = 0;
+                    pg->hand = (pg->hand + 1) % pg->cfg.nframes;
+                }
+                f = pg->hand;
+                pg->hand = (pg->hand + 1) % pg->cfg.nframes;
+                break;
+            default: // LRU
+                f = pg->lru_tail;
+                lru_unlink(pg, f);
+                break;
+        }
+        evict(pg, f);
+    }
+
+    if (pg->cfg.replacement == PAGE_LRU)
+        lru_push(pg, f);
+    else if (pg->cfg.replacement == PAGE_CLOCK)
+        pg->ref[f] = 1;
+    return f;
+}
+
+int paging_access(paging_t *pg, int pid, uint64_t vaddr, int *event) {
+    paging_stats_t *s = &pg->stats;
+    uint64_t vpn = (vaddr & VA_MASK) >> pg->cfg.page_shift;
+    uint64_t key = make_key(pid, vpn);
+    int32_t *pte;
+    int base, w, f;
+
+    s->accesses++;
+    pg->clock++;
+
+    // Fast path: TLB hit
+    if (pg->cfg.tlb_sets > 0) {
+        base = tlb_set(pg, key);
+        for (w = base; w < base + pg->cfg.tlb_ways; w++) {
+            if (pg->tlb_key[w] == key) {
+                pg->tlb_stamp[w] = pg->clock;
+                f = pg->tlb_frame[w];
+                touch(pg, f);
+                s->tlb_hits++;
+                s->latency_ns += pg->cfg.tlb_ns + pg->cfg.mem_ns;
+                if (event != NULL)
+                    *event = PAGE_EVENT_TLB_HIT;
+                return f;
+            }
+        }
+    }
+
+    s->tlb_misses++;
+    s->latency_ns += pg->cfg.tlb_ns + (pg->levels + 1) * pg->cfg.mem_ns;
+    pte = walk(pg, pid, vpn);
+
+    if (*pte != 0) {
+        f = *pte - 1;
+        touch(pg, f);
+        if (event != NULL)
+            *event = PAGE_EVENT_WALK;
+    } else {
+        f = take_frame(pg, key);
+        *pte = f + 1;
+        pg->frame_pte[f] = pte;
+        pg->frame_key[f] = key;
+        s->page_faults++;
+        s->latency_ns += pg->cfg.fault_ns;
+        if (event != NULL)
+            *event = PAGE_EVENT_FAULT;
+    }
+
+    if (pg->cfg.tlb_sets > 0)
+        tlb_insert(pg, key, f);
+    return f;
+}
+
+paging_t *paging_create(const paging_config_t *cfg) {
+    paging_t *pg;
+    int vpn_bits, n, i, entries;
+
+    if (cfg->nframes < 1 || cfg->page_shift < 12 || cfg->page_shift > 30 ||
+        cfg->tlb_sets < 0 || (cfg->tlb_sets & (cfg->tlb_sets - 1)) != 0 ||
+        (cfg->tlb_sets > 0 && cfg->tlb_ways < 1) ||
+        cfg->replacement < PAGE_FIFO || cfg->replacement > PAGE_ARC)
+        return NULL;
+
+    pg = calloc(1, sizeof(paging_t));
+    if (pg == NULL)
+        return NULL;
+    pg->cfg = *cfg;
+    n = cfg->nframes;
+
+    vpn_bits = PAGING_VA_BITS - cfg->page_shift;
+    pg->levels = (vpn_bits + PAGING_LEVEL_BITS - 1) / PAGING_LEVEL_BITS;
+    pg->top_shift = (pg->levels - 1) * PAGING_LEVEL_BITS;
+
+    pg->procs_cap = 64;
+    pg->procs = calloc(pg->procs_cap, sizeof(proc_t));
+    pg->last_pid = 0;
+    pool_init(&pg->nodes, sizeof(pt_node_t), 64);
+    pool_init(&pg->leaves, sizeof(pt_leaf_t), 64);
+
+    pg->frame_key = calloc(n, sizeof(uint64_t));
+    pg->frame_pte = calloc(n, sizeof(int32_t *));
+    pg->ref = calloc(n, 1);
+    pg->lru_prev = malloc(n * sizeof(int));
+    pg->lru_next = malloc(n * sizeof(int));
+    pg->lru_head = pg->lru_tail = NIL;
+
+    if (cfg->tlb_sets > 0) {
+        pg->tlb_mask = cfg->tlb_sets - 1;
+        pg->tlb_key = calloc((size_t)cfg->tlb_sets * cfg->tlb_ways, sizeof(uint64_t));
+        pg->tlb_frame = calloc((size_t)cfg->tlb_sets * cfg->tlb_ways, sizeof(int));
+        pg->tlb_stamp = calloc((size_t)cfg->tlb_sets * cfg->tlb_ways, sizeof(uint64_t));
+    }
+
+    if (cfg->replacement == PAGE_ARC) {
+        entries = 2 * n + 1;
+        pg->arc = malloc(entries * sizeof(arc_entry_t));
+        pg->arc_free = malloc(entries * sizeof(int));
+        for (i = 0; i < entries; i++)
+            pg->arc_free[i] = entries - 1 - i;
+        pg->arc_nfree = entries;
+        pg->arc_hbits = 1;
+        while ((1 << pg->arc_hbits) < 2 * entries)
+            pg->arc_hbits++;
+        pg->arc_bucket = malloc(((size_t)1 << pg->arc_hbits) * sizeof(int));
+        for (i = 0; i < (1 << pg->arc_hbits); i++)
+            pg->arc_bucket[i] = NIL;
+        pg->frame_entry = malloc(n * sizeof(int));
+        for (i = 0; i < ARC_LISTS; i++) {
+            pg->lists[i].head = pg->lists[i].tail = NIL;
+            pg->lists[i].size = 0;
+        }
+    }
+
+    if (pg->procs == NULL || pg->frame_key == NULL || pg->frame_pte == NULL || pg->ref == NULL ||
+        pg->lru_prev == NULL || pg->lru_next == NULL ||
+        (cfg->tlb_sets > 0 && (pg->tlb_key == NULL || pg->tlb_frame == NULL || pg->tlb_stamp == NULL)) ||
+        (cfg->replacement == PAGE_ARC &&
+         (pg->arc == NULL || pg->arc_free == NULL || pg->arc_bucket == NULL || pg->frame_entry == NULL))) {
+        paging_destroy(pg);
+        return NULL;
+    }
+    return pg;
+}
+
+void paging_destroy(paging_t *pg) {
+    if (pg == NULL)
+        return;
+    pool_destroy(&pg->nodes);
+    pool_destroy(&pg->leaves);
+    free(pg->procs);
+    free(pg->frame_key);
+    free(pg->frame_pte);
+    free(pg->ref);
+    free(pg->lru_prev);
+    free(pg->lru_next);
+    free(pg->tlb_key);
+    free(pg->tlb_frame);
+    free(pg->tlb_stamp);
+    free(pg->arc);
+    free(pg->arc_free);
+    free(pg->arc_bucket);
+    free(pg->frame_entry);
+    free(pg);
+}
+
+const paging_stats_t *paging_get_stats(const paging_t *pg) {
+    return &pg->stats;
+}
+
+void paging_print_stats(FILE *out, const paging_t *pg) {
+    const paging_stats_t *s = &pg->stats;
+    double n = s->accesses > 0 ? (double)s->accesses : 1.0;
+
+    fprintf(out, "Summary:\n");
+    fprintf(out, "Replacement:\t\t %s, %d frames of %d bytes\n",
+            paging_policy_name(pg->cfg.replacement), pg->cfg.nframes, 1 << pg->cfg.page_shift);
+    fprintf(out, "TLB:\t\t\t %d sets x %d ways\n", pg->cfg.tlb_sets, pg->cfg.tlb_ways);
+    fprintf(out, "Accesses:\t\t %llu\n", (unsigned long long)s->accesses);
+    fprintf(out, "TLB hits:\t\t %llu (%.4f hit rate)\n",
+            (unsigned long long)s->tlb_hits, s->tlb_hits / n);
+    fprintf(out, "Page faults:\t\t %llu (%.6f per access)\n",
+            (unsigned long long)s->page_faults, s->page_faults / n);
+    fprintf(out, "Evictions:\t\t %llu\n", (unsigned long long)s->evictions);
+    fprintf(out, "Processes:\t\t %llu (%llu page-table nodes, %d levels)\n",
+            (unsigned long long)s->processes, (unsigned long long)s->table_nodes, pg->levels);
+    fprintf(out, "Mean access latency:\t %.2f ns\n", s->latency_ns / n);
+}
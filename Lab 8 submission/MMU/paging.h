@@ -0,0 +1,80 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ * Paging and TLB simulation.
+ *
+ * Each process has a multi-level radix page table over a 48-bit virtual
+ * address space. Translations go through a set-associative TLB with LRU
+ * replacement inside each set; TLB misses walk the page table and misses
+ * there page-fault into a fixed pool of physical frames, evicting a
+ * resident page with FIFO, LRU, Clock or ARC replacement.
+ */
+
+#define PAGE_FIFO 1
+#define PAGE_LRU 2
+#define PAGE_CLOCK 3
+#define PAGE_ARC 4
+
+#define PAGING_VA_BITS 48
+#define PAGING_LEVEL_BITS 9       // 512 entries per page-table node
+
+/* TLB and ARC keys pack the pid above a 40-bit page number (pages are at
+ * least 4 KiB, so page numbers fit in 36 bits); larger pids would alias. */
+#define PAGING_KEY_VPN_BITS 40
+#define PAGING_MAX_PID ((1 << (64 - PAGING_KEY_VPN_BITS)) - 1)
+
+/* Outcome of one access. */
+#define PAGE_EVENT_TLB_HIT 0      // translated by the TLB
+#define PAGE_EVENT_WALK 1         // TLB miss, page resident
+#define PAGE_EVENT_FAULT 2        // page fault
+
+typedef struct paging_config {
+  int nframes;              // physical frames
+  int page_shift;           // log2 of the page size (12..30)
+  int tlb_sets;             // TLB sets (0 disables the TLB)
+  int tlb_ways;             // TLB entries per set
+  int replacement;          // PAGE_FIFO / PAGE_LRU / PAGE_CLOCK / PAGE_ARC
+  double tlb_ns;            // latency of a TLB lookup
+  double mem_ns;            // latency of one memory access (data or PTE)
+  double fault_ns;          // latency of servicing a page fault
+} paging_config_t;
+
+typedef struct paging_stats {
+  uint64_t accesses;
+  uint64_t tlb_hits;
+  uint64_t tlb_misses;
+  uint64_t page_faults;
+  uint64_t evictions;
+  uint64_t walk_levels;     // page-table nodes touched by walks
+  uint64_t processes;
+  uint64_t table_nodes;     // page-table nodes allocated
+  double latency_ns;        // simulated time spent on all accesses
+} paging_stats_t;
+
+typedef struct paging paging_t;
+
+/* Fills cfg with the defaults: 4 KiB pages, 64x4 TLB, LRU replacement,
+ * 1 ns TLB, 100 ns memory and 100 us page faults. */
+void paging_default_config(paging_config_t *cfg, int nframes);
+
+/* Returns NULL if the configuration is invalid or memory runs out. */
+paging_t *paging_create(const paging_config_t *cfg);
+void paging_destroy(paging_t *pg);
+
+/* Translates one reference by pid (1..PAGING_MAX_PID) and returns the
+ * physical frame holding it.
+ * event (may be NULL) receives a PAGE_EVENT_* value. */
+int paging_access(paging_t *pg, int pid, uint64_t vaddr, int *event);
+
+const paging_stats_t *paging_get_stats(const paging_t *pg);
+
+/* Returns the name of a replacement policy ("LRU", ...). */
+const char *paging_policy_name(int replacement);
+
+void paging_print_stats(FILE *out, const paging_t *pg);
+
+#endif				// PAGING_H
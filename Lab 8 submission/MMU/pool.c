@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+// Slab headers are padded so the objects that follow stay 16-byte aligned
+#define POOL_ALIGN 16
+#define POOL_ROUND(x) (((x) + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1))
+
+// Prepares an empty pool for objects of obj_size bytes
+void pool_init(pool_t *p, size_t obj_size, size_t objs_per_slab) {
+    if (obj_size < sizeof(pool_obj_t))
+        obj_size = sizeof(pool_obj_t);
+
+    p->obj_size = (obj_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    p->objs_per_slab = objs_per_slab > 0 ? objs_per_slab : 1;
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->bump = NULL;
+    p->bump_end = NULL;
+    p->in_use = 0;
+}
+
+// Allocates a new slab and makes it the bump region
+static void pool_grow(pool_t *p) {
+    size_t header = POOL_ROUND(sizeof(pool_slab_t));
+    pool_slab_t *slab = malloc(header + p->obj_size * p->objs_per_slab);
+
+    if (slab == NULL) {
+        fprintf(stderr, "Error: pool out of memory\n");
+        exit(1);
+    }
+
+    slab->next = p->slabs;
+    p->slabs = slab;
+    p->bump = (char *)slab + header;
+    p->bump_end = p->bump + p->obj_size * p->objs_per_slab;
+}
+
+// Hands out a recycled object if one exists, otherwise carves a fresh one
+void *pool_get(pool_t *p) {
+    void *obj;
+
+    if (p->free_list != NULL) {
+        obj = p->free_list;
+        p->free_list = p->free_list->next;
+    } else {
+        if (p->bump == p->bump_end)
+            pool_grow(p);
+        obj = p->bump;
+        p->bump += p->obj_size;
+    }
+
+    p->in_use++;
+    return obj;
+}
+
+// Pushes an object onto the free list
+void pool_put(pool_t *p, void *obj) {
+    pool_obj_t *o = obj;
+
+    if (obj == NULL)
+        return;
+
+    o->next = p->free_list;
+    p->free_list = o;
+    p->in_use--;
+}
+
+// Drops every object in one step, keeping the newest slab around
+void pool_reset(pool_t *p) {
+    pool_slab_t *keep = p->slabs;
+    pool_slab_t *slab;
+
+    if (keep == NULL)
+        return;
+
+    slab = keep->next;
+    while (slab != NULL) {
+        pool_slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    keep->next = NULL;
+    p->free_list = NULL;
+    p->bump = (char *)keep + POOL_ROUND(sizeof(pool_slab_t));
+    p->bump_end = p->bump + p->obj_size * p->objs_per_slab;
+    p->in_use = 0;
+}
+
+// Frees every slab; the pool can be reused afterwards as if freshly initialized
+void pool_destroy(pool_t *p) {
+    pool_slab_t *slab = p->slabs;
+
+    while (slab != NULL) {
+        pool_slab_t *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->bump = NULL;
+    p->bump_end = NULL;
+    p->in_use = 0;
+}
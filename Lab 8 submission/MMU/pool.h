@@ -0,0 +1,47 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/**
+ * Fixed-size object pool.
+ *
+ * Objects are carved out of large slabs and handed back through a free list
+ * of recycled objects, so steady-state get/put never touches malloc. The
+ * whole pool is released in one go by pool_reset()/pool_destroy().
+ */
+
+typedef struct pool_slab {
+  struct pool_slab *next;   // slabs are chained so they can be freed in bulk
+} pool_slab_t;
+
+typedef struct pool_obj {
+  struct pool_obj *next;    // link used while an object sits on the free list
+} pool_obj_t;
+
+typedef struct pool {
+  size_t obj_size;          // bytes per object (rounded up for alignment)
+  size_t objs_per_slab;     // objects carved from each slab
+  pool_slab_t *slabs;       // every slab owned by the pool, newest first
+  pool_obj_t *free_list;    // recycled objects, LIFO for cache warmth
+  char *bump;               // next never-used object in the newest slab
+  char *bump_end;           // end of the newest slab
+  size_t in_use;            // objects currently handed out
+} pool_t;
+
+/* Prepares an empty pool; no memory is allocated until the first pool_get. */
+void pool_init(pool_t *p, size_t obj_size, size_t objs_per_slab);
+
+/* Returns an uninitialized object, growing the pool by one slab if needed. */
+void *pool_get(pool_t *p);
+
+/* Gives an object back to the pool for reuse. */
+void pool_put(pool_t *p, void *obj);
+
+/* Invalidates every object at once. The newest slab is kept for reuse. */
+void pool_reset(pool_t *p);
+
+/* Releases every slab owned by the pool. */
+void pool_destroy(pool_t *p);
+
+#endif				// POOL_H
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stats.h"
+
+// Clears all counters for a replay over a partition of the given size
+void stats_init(mmu_stats_t *s, int partition_size) {
+    s->partition_size = partition_size;
+    s->ops = 0;
+    s->alloc_ok = 0;
+    s->alloc_fail = 0;
+    s->dealloc_ok = 0;
+    s->dealloc_fail = 0;
+    s->coalesces = 0;
+    s->alloc_bytes = 0;
+    s->compactions = 0;
+    s->relocations = 0;
+    s->bytes_moved = 0;
+    s->max_pass_moved = 0;
+    s->scan_unit = "blocks";
+    for (int b = 0; b < STATS_SCAN_BUCKETS; b++)
+        s->scan_hist[b] = 0;
+    s->scan_total = 0;
+    s->scan_count = 0;
+    s->scan_max = 0;
+    s->util_sum = 0.0;
+    s->util_peak = 0.0;
+    s->samples = 0;
+    s->frag_sum = 0.0;
+    s->frag_peak = 0.0;
+    s->free_blocks_peak = 0;
+}
+
+// Walks the free list once collecting its total size, largest block and length
+void free_list_summary(list_t *freelist, free_summary_t *out) {
+    node_t *current = freelist->head;
+    int size;
+
+    out->total = 0;
+    out->largest = 0;
+    out->blocks = 0;
+
+    while (current != NULL) {
+        size = current->blk->end - current->blk->start + 1;
+        out->total += size;
+        if (size > out->largest)
+            out->largest = size;
+        out->blocks++;
+        current = current->next;
+    }
+}
+
+// Fraction of free memory that is unusable by a request of the largest free size
+double external_fragmentation(const free_summary_t *fs) {
+    if (fs->total <= 0)
+        return 0.0;
+    return 1.0 - (double)fs->largest / (double)fs->total;
+}
+
+// Updates the per-operation utilization counters
+static void stats_tick(mmu_stats_t *s) {
+    double util = (double)s->alloc_bytes / (double)s->partition_size;
+
+    s->ops++;
+    s->util_sum += util;
+    if (util > s->util_peak)
+        s->util_peak = util;
+}
+
+void stats_record_alloc(mmu_stats_t *s, int ok, int size) {
+    if (ok) {
+        s->alloc_ok++;
+        s->alloc_bytes += size;
+    } else {
+        s->alloc_fail++;
+    }
+    stats_tick(s);
+}
+
+// freed is the size of the released block, or 0 if the pid was not found
+void stats_record_dealloc(mmu_stats_t *s, int freed) {
+    if (freed > 0) {
+        s->dealloc_ok++;
+        s->alloc_bytes -= freed;
+    } else {
+        s->dealloc_fail++;
+    }
+    stats_tick(s);
+}
+
+void stats_record_coalesce(mmu_stats_t *s) {
+    s->coalesces++;
+    stats_tick(s);
+}
+
+void stats_record_scan(mmu_stats_t *s, int scanned) {
+    int b = 0;
+
+    while (b < STATS_SCAN_BUCKETS - 1 && (1 << b) <= scanned)
+        b++;
+    s->scan_hist[b]++;
+    s->scan_total += scanned;
+    s->scan_count++;
+    if (scanned > s->scan_max)
+        s->scan_max = scanned;
+}
+
+int stats_scan_quantile(const mmu_stats_t *s, double q) {
+    long target = (long)(q * s->scan_count);
+    long seen = 0;
+    int b;
+
+    for (b = 0; b < STATS_SCAN_BUCKETS; b++) {
+        seen += s->scan_hist[b];
+        if (seen > target) {
+            int bound = b == 0 ? 0 : (1 << b) - 1;
+            return bound < s->scan_max ? bound : s->scan_max;
+        }
+    }
+    return s->scan_max;
+}
+
+void stats_record_compaction(mmu_stats_t *s, long relocations, long bytes_moved) {
+    if (relocations == 0)
+        return;
+    s->compactions++;
+    s->relocations += relocations;
+    s->bytes_moved += bytes_moved;
+    if (bytes_moved > s->max_pass_moved)
+        s->max_pass_moved = bytes_moved;
+}
+
+void stats_merge(mmu_stats_t *dst, const mmu_stats_t *src) {
+    if (src->partition_size > dst->partition_size)
+        dst->partition_size = src->partition_size;
+    dst->ops += src->ops;
+    dst->alloc_ok += src->alloc_ok;
+    dst->alloc_fail += src->alloc_fail;
+    dst->dealloc_ok += src->dealloc_ok;
+    dst->dealloc_fail += src->dealloc_fail;
+    dst->coalesces += src->coalesces;
+    dst->alloc_bytes += src->alloc_bytes;
+    dst->compactions += src->compactions;
+    dst->relocations += src->relocations;
+    dst->bytes_moved += src->bytes_moved;
+    if (src->max_pass_moved > dst->max_pass_moved)
+        dst->max_pass_moved = src->max_pass_moved;
+    dst->scan_unit = src->scan_unit;
+    for (int b = 0; b < STATS_SCAN_BUCKETS; b++)
+        dst->scan_hist[b] += src->scan_hist[b];
+    dst->scan_total += src->scan_total;
+    dst->scan_count += src->scan_count;
+    if (src->scan_max > dst->scan_max)
+        dst->scan_max = src->scan_max;
+    dst->util_sum += src->util_sum;
+    if (src->util_peak > dst->util_peak)
+        dst->util_peak = src->util_peak;
+    dst->samples += src->samples;
+    dst->frag_sum += src->frag_sum;
+    if (src->frag_peak > dst->frag_peak)
+        dst->frag_peak = src->frag_peak;
+    if (src->free_blocks_peak > dst->free_blocks_peak)
+        dst->free_blocks_peak = src->free_blocks_peak;
+}
+
+// Scans the free list and folds its fragmentation into the running averages
+free_summary_t stats_sample(mmu_stats_t *s, list_t *freelist) {
+    free_summary_t fs;
+    double frag;
+
+    free_list_summary(freelist, &fs);
+    frag = external_fragmentation(&fs);
+
+    s->samples++;
+    s->frag_sum += frag;
+    if (frag > s->frag_peak)
+        s->frag_peak = frag;
+    if (fs.blocks > s->free_blocks_peak)
+        s->free_blocks_peak = fs.blocks;
+    return fs;
+}
+
+void stats_print_timeline(FILE *out, const mmu_stats_t *s, const free_summary_t *fs) {
+    fprintf(out, "OP %ld:\t UTIL: %.4f\t FRAG: %.4f\t LARGEST FREE: %d\t FREE BLOCKS: %d\n",
+            s->ops, (double)s->alloc_bytes / (double)s->partition_size,
+            external_fragmentation(fs), fs->largest, fs->blocks);
+}
+
+void stats_print(FILE *out, const mmu_stats_t *s, list_t *freelist) {
+    free_summary_t fs;
+    long allocs = s->alloc_ok + s->alloc_fail;
+
+    free_list_summary(freelist, &fs);
+
+    fprintf(out, "Summary:\n");
+    fprintf(out, "Operations:\t\t %ld\n", s->ops);
+    fprintf(out, "Allocations:\t\t %ld ok, %ld failed (%.2f%% failure)\n",
+            s->alloc_ok, s->alloc_fail,
+            allocs > 0 ? 100.0 * s->alloc_fail / allocs : 0.0);
+    fprintf(out, "Deallocations:\t\t %ld ok, %ld failed\n", s->dealloc_ok, s->dealloc_fail);
+    fprintf(out, "Coalesce/compact:\t %ld\n", s->coalesces);
+    fprintf(out, "Compaction passes:\t %ld (%ld relocations, %lld bytes moved, max %ld per pass)\n",
+            s->compactions, s->relocations, s->bytes_moved, s->max_pass_moved);
+    fprintf(out, "Allocated bytes:\t %lld of %d\n", s->alloc_bytes, s->partition_size);
+    fprintf(out, "Free bytes:\t\t %lld in %d blocks\n", fs.total, fs.blocks);
+    fprintf(out, "Largest free block:\t %d\n", fs.largest);
+    fprintf(out, "External fragmentation:\t %.4f (mean %.4f, peak %.4f)\n",
+            external_fragmentation(&fs),
+            s->samples > 0 ? s->frag_sum / s->samples : 0.0, s->frag_peak);
+    fprintf(out, "Peak free blocks:\t %d\n", s->free_blocks_peak);
+    fprintf(out, "Scan length:\t\t mean %.2f, p50 <= %d, p99 <= %d, max %d %s\n",
+            s->scan_count > 0 ? (double)s->scan_total / s->scan_count : 0.0,
+            stats_scan_quantile(s, 0.50), stats_scan_quantile(s, 0.99), s->scan_max,
+            s->scan_unit);
+    fprintf(out, "Utilization:\t\t mean %.4f, peak %.4f\n",
+            s->ops > 0 ? s->util_sum / s->ops : 0.0, s->util_peak);
+}
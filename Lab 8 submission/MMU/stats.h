@@ -0,0 +1,94 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "list.h"
+
+/**
+ * Aggregate statistics for an MMU replay
+ */
+
+/* Scan lengths are bucketed by powers of two: bucket b holds [2^(b-1), 2^b). */
+#define STATS_SCAN_BUCKETS 32
+
+typedef struct mmu_stats {
+  int partition_size;
+  long ops;                 // operations replayed
+  long alloc_ok;            // successful allocations
+  long alloc_fail;          // allocations with no fitting block
+  long dealloc_ok;          // successful deallocations
+  long dealloc_fail;        // deallocations of unknown pids
+  long coalesces;           // COALESCE/COMPACT operations
+  long long alloc_bytes;    // bytes currently allocated
+
+  /* Relocating compaction. */
+  long compactions;         // passes that moved at least one block
+  long relocations;         // blocks moved
+  long long bytes_moved;    // bytes moved in total
+  long max_pass_moved;      // most bytes moved by one pass (pause proxy)
+
+  /* Free blocks examined per allocation, or bitmap words for the bitmap
+   * backend; scan_unit names which. */
+  const char *scan_unit;
+  long scan_hist[STATS_SCAN_BUCKETS];
+  long long scan_total;
+  long scan_count;
+  int scan_max;
+
+  /* Utilization (allocated / partition) is tracked on every operation. */
+  double util_sum;
+  double util_peak;
+
+  /* Free-list shape is sampled by scanning the free list. */
+  long samples;
+  double frag_sum;
+  double frag_peak;
+  int free_blocks_peak;
+} mmu_stats_t;
+
+/* Shape of a free list at one point in time. */
+typedef struct free_summary {
+  long long total;          // free bytes
+  int largest;              // largest free block
+  int blocks;               // number of free blocks
+} free_summary_t;
+
+/* Clears all counters; scans are counted in free blocks until scan_unit is
+ * changed. */
+void stats_init(mmu_stats_t *s, int partition_size);
+
+/* Scans the free list once and returns its total, largest block and count. */
+void free_list_summary(list_t *freelist, free_summary_t *out);
+
+/* External fragmentation: 1 - largest free block / total free bytes. */
+double external_fragmentation(const free_summary_t *fs);
+
+/* Records the outcome of one operation (O(1)). size is the size of the
+ * block actually allocated, which may be larger than the request. */
+void stats_record_alloc(mmu_stats_t *s, int ok, int size);
+void stats_record_dealloc(mmu_stats_t *s, int freed);
+void stats_record_coalesce(mmu_stats_t *s);
+
+/* Records how many free blocks (or bitmap words) one allocation examined. */
+void stats_record_scan(mmu_stats_t *s, int scanned);
+
+/* Upper bound of the scan-length bucket holding quantile q (0..1). */
+int stats_scan_quantile(const mmu_stats_t *s, double q);
+
+/* Records the bytes moved by one compaction pass (does not count an op). */
+void stats_record_compaction(mmu_stats_t *s, long relocations, long bytes_moved);
+
+/* Folds the counters of src into dst: totals and histograms are summed and
+ * peaks take the maximum. Used to combine replays of different traces. */
+void stats_merge(mmu_stats_t *dst, const mmu_stats_t *src);
+
+/* Samples the free list shape; returns the summary that was taken. */
+free_summary_t stats_sample(mmu_stats_t *s, list_t *freelist);
+
+/* Prints one row of the utilization timeline. */
+void stats_print_timeline(FILE *out, const mmu_stats_t *s, const free_summary_t *fs);
+
+/* Prints the final summary report. */
+void stats_print(FILE *out, const mmu_stats_t *s, list_t *freelist);
+
+#endif				// STATS_H
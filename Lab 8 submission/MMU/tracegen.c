@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Synthetic MMU trace generator.
+ *
+ * Writes a trace in the mmu input format (partition size, then one
+ * "pid size" / "-pid 0" / "-99999 0" operation per line) to stdout.
+ * Each allocation draws a size from the chosen distribution and an
+ * exponentially distributed lifetime; a free is emitted when it expires.
+ */
+
+#define TRACEGEN_USAGE "usage: ./tracegen <uniform | small | bimodal | pareto> <ops> <partition size> " \
+    "[mean lifetime] [coalesce every] [seed]\n"
+
+// A live allocation and the operation count at which it is freed
+typedef struct live {
+    long death;
+    int pid;
+} live_t;
+
+static uint64_t rng_state;
+
+// xorshift64* generator, reproducible for a given seed
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ULL;
+}
+
+// Uniform double in (0, 1)
+static double rng_unit(void) {
+    return ((rng_next() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform integer in [lo, hi]
+static int rng_range(int lo, int hi) {
+    return lo + (int)(rng_next() % (uint64_t)(hi - lo + 1));
+}
+
+// Draws a request size from the named distribution
+static int draw_size(const char *dist, int partition) {
+    int max = partition / 64 > 16 ? partition / 64 : 16;
+    int size;
+
+    if (strcmp(dist, "uniform") == 0) {
+        size = rng_range(1, 8192);
+    } else if (strcmp(dist, "small") == 0) {
+        // Mostly small objects with an occasional medium one
+        size = rng_unit() < 0.9 ? rng_range(8, 256) : rng_range(257, 8192);
+    } else if (strcmp(dist, "bimodal") == 0) {
+        // Small headers mixed with large buffers; the buffers straddle the
+        // default huge-page threshold (1 MiB) so both kinds of placement occur
+        size = rng_unit() < 0.9 ? rng_range(16, 128) : rng_range(256 * 1024, 2 * 1024 * 1024);
+    } else {
+        // Pareto, alpha = 1.2, minimum 16 bytes; clamped before the cast,
+        // since the tail overflows an int for small draws
+        double x = 16.0 / pow(rng_unit(), 1.0 / 1.2);
+
+        size = x > max ? max : (int)x;
+    }
+
+    if (size > max)
+        size = max;
+    return size < 1 ? 1 : size;
+}
+
+// Min-heap on death time
+static void heap_push(live_t *heap, int *n, live_t item) {
+    int i = (*n)++;
+
+    while (i > 0 && heap[(i - 1) / 2].death > item.death) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = item;
+}
+
+static live_t heap_pop(live_t *heap, int *n) {
+    live_t top = heap[0];
+    live_t last = heap[--(*n)];
+    int i = 0, child;
+
+    while ((child = 2 * i + 1) < *n) {
+        if (child + 1 < *n && heap[child + 1].death < heap[child].death)
+            child++;
+        if (last.death <= heap[child].death)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+int main(int argc, char *argv[]) {
+    static char outbuf[1 << 20];
+    live_t *heap;
+    int heap_len = 0, heap_cap = 1024;
+    long ops, op, coalesce_every = 1000;
+    double lifetime = 1000.0;
+    int partition, pid = 0;
+    const char *dist;
+
+    if (argc < 4) {
+        printf(TRACEGEN_USAGE);
+        exit(1);
+    }
+
+    dist = argv[1];
+    if (strcmp(dist, "uniform") != 0 && strcmp(dist, "small") != 0 &&
+        strcmp(dist, "bimodal") != 0 && strcmp(dist, "pareto") != 0) {
+        printf(TRACEGEN_USAGE);
+        exit(1);
+    }
+    ops = atol(argv[2]);
+    partition = atoi(argv[3]);
+    if (argc > 4)
+        lifetime = atof(argv[4]);
+    if (argc > 5)
+        coalesce_every = atol(argv[5]);
+    rng_state = argc > 6 ? strtoull(argv[6], NULL, 10) : 88172645463325252ULL;
+    if (rng_state == 0)
+        rng_state = 88172645463325252ULL;
+
+    if (ops <= 0 || partition <= 0 || lifetime <= 0) {
+        printf(TRACEGEN_USAGE);
+        exit(1);
+    }
+
+    heap = malloc(sizeof(live_t) * heap_cap);
+    if (heap == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+    printf("%d\n", partition);
+
+    for (op = 0; op < ops; op++) {
+        if (coalesce_every > 0 && op % coalesce_every == coalesce_every - 1) {
+            printf("-99999 0\n");
+        } else if (heap_len > 0 && heap[0].death <= op) {
+            printf("%d 0\n", -heap_pop(heap, &heap_len).pid);
+        } else {
+            live_t item;
+
+            if (heap_len == heap_cap) {
+                live_t *grown = realloc(heap, sizeof(live_t) * heap_cap * 2);
+
+                if (grown == NULL) {
+                    fprintf(stderr, "Error: out of memory\n");
+                    free(heap);
+                    exit(1);
+                }
+                heap = grown;
+                heap_cap *= 2;
+            }
+            if (pid == 0x7fffffff - 1)
+                pid = 0;
+            item.pid = ++pid;
+            item.death = op + 1 + (long)(-lifetime * log(rng_unit()));
+            heap_push(heap, &heap_len, item);
+            printf("%d %d\n", item.pid, draw_size(dist, partition));
+        }
+    }
+
+    free(heap);
+    return 0;
+}
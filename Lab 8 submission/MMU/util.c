@@ -3,34 +3,188 @@
 #include<unistd.h>
 #include<stdlib.h>
 #include<errno.h>
+#include<limits.h>
 
 #include "util.h"
 #include "list.h"
+#include "paging.h"
+
+// Refills the read buffer; returns the number of bytes now available
+static size_t trace_fill(trace_t *t) {
+  if (t->pos < t->len)
+    return t->len - t->pos;
+
+  t->len = fread(t->buf, 1, TRACE_BUF_SIZE, t->f);
+  t->pos = 0;
+  return t->len;
+}
+
+// Skips whitespace; returns the next character or EOF without consuming it
+static int trace_peek(trace_t *t) {
+  while (trace_fill(t) > 0) {
+    char c = t->buf[t->pos];
+    if (c == '\n')
+      t->line++;
+    else if (c != ' ' && c != '\t' && c != '\r')
+      return (unsigned char)c;
+    t->pos++;
+  }
+  return EOF;
+}
 
 /**
- * Returns an array of process that are parsed from
- * the input file descriptor passed as argument
- * CAUTION: You need to free up the space that is allocated
- * by this function
+ * Reads one signed integer from the trace.
+ * Returns 1 on success, 0 at end of input, -1 on a malformed token
  */
-void parse_file(FILE * f, int input[][2], int *n, int *PARTITION_SIZE)
+static int trace_read_int(trace_t *t, int *out)
 {
-  
-  // get the initial partition sizeof
-  
-  fscanf(f,"%d\n", PARTITION_SIZE);
-  printf("PARTITION_SIZE = %d\n", *PARTITION_SIZE);
-  
-  while (!feof(f)) {
-		fscanf(f, "%d %d\n", &input[*n][0], &input[*n][1]);
-    /*
-    if(input[*n][0] != -99999 && input[*n][0] > 0)
-        printf("PID=%d ALLOCATE=%dbytes\n", input[*n][0], input[*n][1]);
-    else if (input[*n][0] != -99999 && input[*n][0] < 0)
-        printf("DEALLOCATED PROC = %d\n", abs(input[*n][0]));
+  long long value = 0;
+  int negative = 0;
+  int digits = 0;
+  int c = trace_peek(t);
+
+  if (c == EOF)
+    return 0;
+
+  if (c == '-' || c == '+') {
+    negative = (c == '-');
+    t->pos++;
+  }
+
+  while (trace_fill(t) > 0) {
+    c = t->buf[t->pos];
+    if (c < '0' || c > '9')
+      break;
+    value = value * 10 + (c - '0');
+    if (value > (long long)INT_MAX + 1)
+      return -1;
+    digits++;
+    t->pos++;
+  }
+
+  if (digits == 0)
+    return -1;
+  if (negative)
+    value = -value;
+  if (value > INT_MAX || value < INT_MIN)
+    return -1;
+
+  *out = (int)value;
+  return 1;
+}
+
+/**
+ * Reads one unsigned address, decimal or 0x-prefixed hex.
+ * Returns 1 on success, 0 at end of input, -1 on a malformed token
+ */
+static int trace_read_addr(trace_t *t, uint64_t *out)
+{
+  uint64_t value = 0;
+  int digits = 0;
+  int hex = 0;
+  int c = trace_peek(t);
+
+  if (c == EOF)
+    return 0;
+
+  if (c == '0') {
+    t->pos++;
+    digits = 1;
+    if (trace_fill(t) > 0 && (t->buf[t->pos] == 'x' || t->buf[t->pos] == 'X')) {
+      t->pos++;
+      hex = 1;
+      digits = 0;
+    }
+  }
+
+  while (trace_fill(t) > 0) {
+    c = t->buf[t->pos];
+    if (c >= '0' && c <= '9')
+      c -= '0';
+    else if (hex && c >= 'a' && c <= 'f')
+      c -= 'a' - 10;
+    else if (hex && c >= 'A' && c <= 'F')
+      c -= 'A' - 10;
     else
-        printf("COALESCE\n");
-    */
-    *n += 1;
-	}
-}
\ No newline at end of file
+      break;
+    value = hex ? (value << 4) | c : value * 10 + c;
+    digits++;
+    t->pos++;
+  }
+
+  if (digits == 0)
+    return -1;
+  *out = value;
+  return 1;
+}
+
+// Reports a malformed trace once and stops the reader
+static void trace_fail(trace_t *t)
+{
+  if (!t->error)
+    fprintf(stderr, "Error: malformed trace at line %ld\n", t->line);
+  t->error = 1;
+}
+
+/**
+ * Attaches the reader to an open trace file and reads the
+ * initial partition size
+ */
+int trace_open(trace_t *t, FILE * f, int *PARTITION_SIZE)
+{
+  t->f = f;
+  t->pos = 0;
+  t->len = 0;
+  t->line = 1;
+  t->error = 0;
+
+  if (trace_read_int(t, PARTITION_SIZE) != 1 || *PARTITION_SIZE <= 0) {
+    trace_fail(t);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Reads the next chunk of at most max operations. Each operation
+ * is a pid/size pair; the chunk is never written past max entries
+ */
+int trace_next_chunk(trace_t *t, int ops[][2], int max)
+{
+  int n = 0;
+  int rc;
+
+  while (n < max && !t->error) {
+    rc = trace_read_int(t, &ops[n][0]);
+    if (rc == 0)
+      break;
+    if (rc < 0 || trace_read_int(t, &ops[n][1]) != 1) {
+      trace_fail(t);
+      break;
+    }
+    n++;
+  }
+  return n;
+}
+
+/**
+ * Reads the next chunk of at most max virtual-address references
+ */
+int trace_next_refs(trace_t *t, int pids[], uint64_t addrs[], int max)
+{
+  int n = 0;
+  int rc;
+
+  while (n < max && !t->error) {
+    rc = trace_read_int(t, &pids[n]);
+    if (rc == 0)
+      break;
+    if (rc < 0 || pids[n] <= 0 || pids[n] > PAGING_MAX_PID ||
+        trace_read_addr(t, &addrs[n]) != 1) {
+      trace_fail(t);
+      break;
+    }
+    n++;
+  }
+  return n;
+}
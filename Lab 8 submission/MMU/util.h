@@ -1,11 +1,39 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <stdio.h>
+#include <stdint.h>
+
 /**
  * Utility function file
  */
 
+/* Size of the read buffer used by the trace reader. */
+#define TRACE_BUF_SIZE (1 << 16)
+
+/* Streaming reader for MMU traces. The trace is read through a fixed buffer
+ * and handed out in chunks, so memory use does not depend on trace length. */
+typedef struct trace {
+  FILE *f;
+  char buf[TRACE_BUF_SIZE];
+  size_t pos;               // next unread byte in buf
+  size_t len;               // valid bytes in buf
+  long line;                // current line, for error messages
+  int error;                // set once a malformed token is seen
+} trace_t;
+
+/* Attaches the reader to f and reads the partition size header.
+ * Returns 0 on success, -1 if the header is missing or malformed. */
+int trace_open(trace_t *t, FILE *f, int *PARTITION_SIZE);
+
+/* Reads up to max operations into ops. Returns the number read; 0 means the
+ * trace is exhausted (check t->error to tell a malformed trace from EOF). */
+int trace_next_chunk(trace_t *t, int ops[][2], int max);
 
-void parse_file(FILE *, int [][2], int *, int *);
+/* Reads up to max virtual-address references ("pid address" pairs, the
+ * address in decimal or 0x-prefixed hex) for the paging mode. Pids must be
+ * in 1..PAGING_MAX_PID. Returns the number read; 0 means the trace is
+ * exhausted or malformed. */
+int trace_next_refs(trace_t *t, int pids[], uint64_t addrs[], int max);
 
-#endif				// UTIL_H
\ No newline at end of file
+#endif				// UTIL_H